@@ -1,67 +1,488 @@
 #ifndef _HW2_ANNEALING_H
 #define _HW2_ANNEALING_H
 
+#include "pool.h"
+#include "random.h"
+
 #include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <limits>
 #include <memory>
-#include <mutex>
+#include <optional>
 #include <random>
+#include <stdexcept>
 #include <thread>
 #include <vector>
 
 namespace hw2 {
+    class Workers;
+    class Budget;
+
+    template<class S, class M, class C>
+    class Chain;
+
+    template<class S, class M, class C>
+    class BasicAnnealing;
+
     class Annealing;
 
     class Solution;
     class Mutation;
     class Cooldown;
+    class Stopping;
+
+    class SolutionRef;
+    class MutationRef;
+    class CooldownRef;
+
+    struct Progress;
+    struct CheckpointHeader;
+    struct Counters;
+    struct Sample;
+    struct Statistics;
 
     namespace BasicCD {
         class Boltzmann;
         class Cauchy;
         class LogCauchy;
+        class Adaptive;
+        class Reheating;
+        class Table;
+    }
+
+    namespace BasicStop {
+        class Stall;
+        class Deadline;
+        class Evaluations;
+        class Target;
+        class Any;
     }
 
     using SolutionPtr = std::shared_ptr<Solution>;
     using MutationPtr = std::shared_ptr<Mutation>;
     using CooldownPtr = std::shared_ptr<Cooldown>;
+    using StoppingPtr = std::shared_ptr<Stopping>;
+
+    using Clock = std::chrono::steady_clock;
 } // namespace hw2
 
-class hw2::Annealing {
+// What a worker did during a run. Times are only measured when
+// profiling is on, except for `wait`.
+struct hw2::Counters {
+    unsigned long iterations;
+    unsigned long accepted;
+    unsigned long uphill;           // Accepted moves to a worse solution.
+    Clock::duration mutate;         // Spent proposing moves.
+    Clock::duration evaluate;       // Spent computing the criterion.
+    Clock::duration wait;           // Spent done, waiting for the round
+                                    // to end.
+
+    Counters &operator+=(const Counters &cnt) {
+        iterations += cnt.iterations;
+        accepted += cnt.accepted;
+        uphill += cnt.uphill;
+        mutate += cnt.mutate;
+        evaluate += cnt.evaluate;
+        wait += cnt.wait;
+        return *this;
+    }
+
+    double acceptance(void) const {
+        return iterations ? double(accepted) / iterations : 0.;
+    }
+};
+
+// State of a chain, recorded every `trace_period` steps of a worker.
+struct hw2::Sample {
+    unsigned worker;
+    unsigned long iteration;        // Steps of the worker so far.
+    Clock::duration elapsed;        // Since the start of the run.
+    double temp;
+    double current;                 // Criterion of the chain.
+    double best;                    // Best criterion of the chain.
+};
+
+struct hw2::Statistics {
+    std::vector<Counters> workers;
+    std::vector<Sample> trace;      // Ordered by time.
+
+    Counters total(void) const {
+        Counters ans = {};
+
+        for (const auto &cnt: workers) {
+            ans += cnt;
+        }
+
+        return ans;
+    }
+};
+
+// What a stopping policy gets to see of a run in progress.
+struct hw2::Progress {
+    unsigned long evaluations;      // Criterion evaluations so far.
+    double criterion;               // Best criterion so far.
+    unsigned not_improved;          // Rounds (chains if async) in a row
+                                    // without a new best.
+    Clock::duration elapsed;
+};
+
+// Threads that run a payload in rounds, for the engines that search in
+// parallel. They are started once and live as long as the object does.
+// Every round is framed by two phases of a barrier: the coordinator
+// arrives once in `launch` to let the workers go, and once in `wait`
+// to collect their results. Worker `id` is passed its own generator,
+// seeded from `seed`.
+class hw2::Workers {
+public:
+    using Payload = std::function<void(unsigned, Random&)>;
+
+private:
     std::vector<std::thread> threads;
-    std::vector<SolutionPtr> locals;
-    SolutionPtr best;
-    MutationPtr mutation;
-    CooldownPtr cooldown;
-    mutable std::mutex mutex;
+    std::barrier<> round;
+    Payload payload;
+    bool stopping;
 
-    void thread_payload(void);
+    void worker(unsigned, Random::result_type);
 
 public:
-    Annealing(unsigned n_proc, MutationPtr mut, CooldownPtr cd)
-        : threads(n_proc)
-        , best(nullptr)
-        , mutation(mut)
-        , cooldown(cd)
-    {}
+    Workers(unsigned, Payload, Random::result_type);
+    Workers(const Workers&) = delete;
+    Workers &operator=(const Workers&) = delete;
+    ~Workers();
+
+    unsigned size(void) const { return threads.size(); }
+
+    void launch(void) { round.arrive_and_wait(); }
+    void wait(void) { round.arrive_and_wait(); }
+    void run(void) { launch(); wait(); }
+};
+
+// When a parallel run stops: the counters of the run, its best
+// criterion so far, the stopping policy and the lower bound, shared by
+// the coordinator and the workers of an engine. The coordinator starts
+// the run with `begin` and runs its rounds with `drive`, workers count
+// their evaluations with `charge`, at least every `check_period` of
+// them, and report every new best with `reached`.
+class hw2::Budget {
+public:
+    static constexpr unsigned check_period = 1024u;
+
+protected:
+    StoppingPtr stop;
+    std::atomic<Clock::time_point> start;
+    std::atomic<double> crit_global;
+    std::atomic<unsigned long> evaluations;
+    std::atomic<unsigned> stall;
+    std::atomic<bool> finished;
+    double bound;                       // Lower bound on the criterion.
+
+    void begin(StoppingPtr, double, double, Progress = {});
+    bool exhausted(void);
+    bool tally(double);
+    bool charge(unsigned);
+    bool reached(double);
+
+    template<class P, class F>
+    P drive(Workers&, std::vector<P>&, P, F);
+
+public:
+    Budget(void);
+
+    Progress progress(void) const;
+    double gap(void) const;
+    void request_stop(void);
+};
+
+// A Metropolis chain over `sol`, one `step` at a time, shared by all
+// the engines that anneal so that they accept, report and stop alike.
+// `S`, `M` and `C` are as in `BasicAnnealing`. The chain is done once
+// it stalls for `patience` steps or reaches `bound`, its owner decides
+// when to check anything else in between steps.
+template<class S, class M, class C>
+class hw2::Chain {
+public:
+    static constexpr unsigned patience = 10u;
+
+private:
+    S &sol;
+    M &mut;
+    C &cool;
+    Random &rng;
+    std::uniform_real_distribution<double> dist;
+    double bound;
+    bool profile;                       // Time the moves in `cnt`.
+
+    double crit_cur;
+    double crit_best;
+    double temp;                        // Of the last step.
+    unsigned it;
+    unsigned not_improved;
+    Counters cnt;
+
+public:
+    Chain(
+        S&, M&, C&, Random&,
+        double = -std::numeric_limits<double>::infinity(), bool = false
+    );
+
+    bool done(void) const {
+        return not_improved >= patience || crit_best <= bound;
+    }
+
+    bool step(void);
+
+    double current(void) const { return crit_cur; }
+    double best(void) const { return crit_best; }
+    double temperature(void) const { return temp; }
+    const Counters &counters(void) const { return cnt; }
+};
+
+// Annealing engine over value types, resolved at compile time.
+// `S` is copyable and has `criterion`, `commit` and `undo` (see
+// `hw2::Solution`), `M` has `propose(S&, Random&)`, optionally
+// `feedback(bool, double)` (see `hw2::Mutation`), and every worker runs
+// its own copy of it, `C` has `get_temp(unsigned) const` and optionally
+// `feedback(bool, double)`, every worker runs its own copy of it too.
+// Solutions are shared between threads as immutable snapshots,
+// each worker mutates a private copy of its starting point.
+//
+// The workers run in rounds, see `hw2::Workers`, and the run stops as
+// `hw2::Budget` says. An asynchronous run is a single long round, in
+// which the workers exchange solutions through `global` instead of
+// waiting for each other.
+// Workers check the stopping policy every `check_period` steps, so a run
+// is interrupted in the middle of a round when its budget runs out.
+//
+// With `checkpoint` set, the coordinator saves the best solution and
+// the progress counters every so often, between rounds, or by polling
+// `global` during an asynchronous run. The file is written by a
+// separate thread from an immutable snapshot, and the workers never
+// wait for it. This needs `S` to have `write(std::ostream&) const` and
+// `read(std::istream&)`, see `hw2::Solution`, without them checkpoints
+// are refused. A failed write does not interrupt the run, it is
+// reported by `checkpoint_error` afterwards.
+//
+// A run in progress can be watched from any thread through `snapshot`,
+// or reported to an observer by the coordinator, see `observe`, and
+// cut short by `request_stop`.
+//
+// If `S` has `lower_bound() const`, a run also stops as soon as
+// a solution reaches the bound, which proves it optimal.
+//
+// Each worker counts its steps in a slot of its own, without locks,
+// and the coordinator gathers the slots into `statistics` once the run
+// is over. Timing the moves and sampling a trace are opt-in, see
+// `instrument`.
+template<class S, class M, class C>
+class hw2::BasicAnnealing: public hw2::Budget {
+public:
+    using Snapshot = std::shared_ptr<const S>;
+
+    // A run in progress, as seen by `snapshot`.
+    struct Report {
+        Progress progress;
+        unsigned long rounds;           // Chains if async.
+        std::vector<double> temperatures;   // Of each worker's chain.
+        Snapshot best;                  // Null between runs.
+    };
+
+    using Observer = std::function<void(const Report&)>;
+
+private:
+    // Shortest period of checkpoints and reports, and how often an
+    // asynchronous run polls for them.
+    static constexpr Clock::duration poll_period =
+        std::chrono::milliseconds(10);
+
+    // Instrumentation and memory of a worker, only written to by its
+    // owner while a round is in progress.
+    struct alignas(64) Slot {
+        std::vector<Sample> trace;
+        Clock::time_point done;         // When the last payload returned.
+        Counters counters;
+        std::optional<S> scratch;       // The chain, reused between chains.
+        Pool<S> pool;                   // Snapshots of the chain.
+        std::atomic<double> temp;       // Sampled for `snapshot`.
+        std::optional<M> mut;           // Copies for the run, so that
+        std::optional<C> cool;          // their state starts afresh.
+    };
+
+    std::vector<Snapshot> locals;       // Where each worker starts from,
+                                        // then what it ended with.
+    std::vector<Slot> slots;
+    Snapshot best;
+    M mutation;
+    C cooldown;
+    bool async;
+    bool profile;
+    unsigned trace_period;
+    Statistics stats;
+
+    // State of the current run, shared with the workers.
+    std::atomic<Snapshot> global;
+    std::atomic<unsigned long> rounds;
+
+    // Reports to the observer, made by the coordinator.
+    Observer observer;
+    Clock::duration obs_period;
+    Clock::time_point obs_last;
+
+    // Checkpoints, written by `writer` while the run goes on.
+    std::filesystem::path ckpt_path;
+    Clock::duration ckpt_period;
+    Clock::time_point ckpt_last;
+    std::thread writer;
+    std::atomic<bool> writing;
+    std::exception_ptr failure;
+
+    Workers crew;                       // Last, to stop before the rest.
+
+    void worker(unsigned, Random&);
+    Snapshot thread_payload(Snapshot, M&, C&, Random&, Slot&);
+    void async_payload(Snapshot, M&, C&, Random&, Slot&);
+    bool publish(Snapshot);
+    void prepare(std::vector<S>&&, StoppingPtr, Progress = {});
+    void collect(void);
+    void gather(void);
+    Snapshot run_rounds(void);
+    Snapshot run_free(void);
+    void save(Snapshot);
+    void finish_save(void);
+    void notify(void);
+
+public:
+    BasicAnnealing(
+        unsigned, M, C,
+        Random::result_type = std::random_device{}()
+    );
+    BasicAnnealing(const BasicAnnealing&) = delete;
+    BasicAnnealing &operator=(const BasicAnnealing&) = delete;
+    ~BasicAnnealing();
+
+    Snapshot run(S);
+    Snapshot run(S, StoppingPtr);
+    Snapshot run(std::vector<S>);
+    Snapshot run(std::vector<S>, StoppingPtr);
+    Snapshot run_async(S);
+    Snapshot run_async(S, StoppingPtr);
+    Snapshot run_async(std::vector<S>);
+    Snapshot run_async(std::vector<S>, StoppingPtr);
+    Snapshot resume(const std::filesystem::path&, S, StoppingPtr);
+    Snapshot resume_async(const std::filesystem::path&, S, StoppingPtr);
 
-    SolutionPtr run(SolutionPtr);
+    Report snapshot(void) const;
+    void observe(Observer, Clock::duration);
+
+    void checkpoint(const std::filesystem::path&, Clock::duration);
+    static Progress load(const std::filesystem::path&, S&);
+
+    // The first checkpoint failure of the last run, if any.
+    std::exception_ptr checkpoint_error(void) const { return failure; }
+
+    void instrument(bool, unsigned = 0u);
+    const Statistics &statistics(void) const { return stats; }
 };
 
+// The criterion is computed by `evaluate` at most once per state:
+// subclasses call `invalidate` whenever the solution changes.
+// Concurrent readers of a shared solution may both compute it,
+// the cache itself is atomic.
 class hw2::Solution {
+    mutable std::atomic<double> score;
+
+protected:
+    virtual double evaluate(void) const = 0;
+
+    void invalidate(void) {
+        score.store(
+            std::numeric_limits<double>::quiet_NaN(),
+            std::memory_order_relaxed
+        );
+    }
+
+    void restore(double crit) {
+        score.store(crit, std::memory_order_relaxed);
+    }
+
 public:
+    Solution(): score(std::numeric_limits<double>::quiet_NaN()) {}
+    Solution(const Solution &sol)
+        : score(sol.score.load(std::memory_order_relaxed))
+    {}
+    Solution &operator=(const Solution&);
     virtual ~Solution() = default;
 
-    virtual double criterion(void) const = 0;
+    double criterion(void) const;
+
+    // In-place mutation protocol: `Mutation::propose` changes the solution
+    // and remembers how, then either `commit` or `undo` must follow.
+    virtual SolutionPtr clone(void) const = 0;
+    virtual void commit(void) = 0;
+    virtual void undo(void) = 0;
+
+    // Binary form of the solution for checkpoints, `read` replaces
+    // the state of a solution of the same problem. Not supported by
+    // default.
+    virtual void write(std::ostream&) const {
+        throw std::invalid_argument("checkpoints not supported");
+    }
+
+    virtual void read(std::istream&) {
+        throw std::invalid_argument("checkpoints not supported");
+    }
+
+    // No criterion of the problem is below it, none by default.
+    virtual double lower_bound(void) const {
+        return -std::numeric_limits<double>::infinity();
+    }
+
+    // Opt-in copy into an existing object, which lets the engine reuse
+    // solutions and their buffers: return false if `sol` can't be
+    // assigned, and the engine clones it instead.
+    virtual bool assign(const Solution&) {
+        return false;
+    }
+
+    // Attributes of the pending move for tabu search, hashed: `move_key`
+    // of what it creates, `undo_key` of what it destroys. The search
+    // records `undo_key` of every move it applies and makes tabu a later
+    // move with that `move_key`, so `undo_key` of a move must equal
+    // `move_key` of its reversal. Zero means none, never tabu.
+    virtual std::uint64_t move_key(void) const {
+        return 0u;
+    }
+
+    virtual std::uint64_t undo_key(void) const {
+        return 0u;
+    }
 };
 
+// Engines give every worker a clone of the mutation, so it may keep
+// state, and report the fate of each proposed move to `feedback`:
+// whether it was accepted and how much it lowered the criterion.
 class hw2::Mutation {
 public:
     virtual ~Mutation() = default;
 
-    virtual SolutionPtr mutate(SolutionPtr) = 0;
+    virtual MutationPtr clone(void) const = 0;
+    virtual void propose(Solution&, Random&) = 0;
+    virtual SolutionPtr mutate(SolutionPtr, Random&);
+    virtual void feedback(bool, double) {}
 };
 
+// Like mutations, cooldowns are cloned for every worker and told
+// the fate of every move, adaptive ones use it to set the temperature.
 class hw2::Cooldown {
 protected:
     const double temp0;
@@ -70,7 +491,9 @@ public:
     Cooldown(double init): temp0(init) {}
     virtual ~Cooldown() = default;
 
+    virtual CooldownPtr clone(void) const = 0;
     virtual double get_temp(unsigned) const = 0;
+    virtual void feedback(bool, double) {}
 };
 
 class hw2::BasicCD::Boltzmann final: public hw2::Cooldown {
@@ -78,6 +501,10 @@ public:
     Boltzmann(double init): Cooldown(init) {}
     ~Boltzmann() = default;
 
+    CooldownPtr clone(void) const override {
+        return std::make_shared<Boltzmann>(*this);
+    }
+
     double get_temp(unsigned it) const override {
         if (it) {
             return temp0 / std::log(1. + it);
@@ -91,6 +518,10 @@ public:
     Cauchy(double init): Cooldown(init) {}
     ~Cauchy() = default;
 
+    CooldownPtr clone(void) const override {
+        return std::make_shared<Cauchy>(*this);
+    }
+
     double get_temp(unsigned it) const override {
         if (it) {
             return temp0 / (1. + it);
@@ -104,6 +535,10 @@ public:
     LogCauchy(double init): Cooldown(init) {}
     ~LogCauchy() = default;
 
+    CooldownPtr clone(void) const override {
+        return std::make_shared<LogCauchy>(*this);
+    }
+
     double get_temp(unsigned it) const override {
         if (it) {
             double itp1 = 1. + it;
@@ -113,79 +548,1196 @@ public:
     }
 };
 
-void hw2::Annealing::thread_payload(void) {
-    std::mt19937 rng(std::random_device{}());
-    std::uniform_real_distribution dist(0., 1.);
+// Keeps the ratio of accepted uphill moves close to `target`: the
+// temperature drops after every accepted one and rises after every
+// rejected one, by factors that balance out at that ratio.
+// Ignores the iteration number, the state carries over between chains.
+class hw2::BasicCD::Adaptive final: public hw2::Cooldown {
+    const double cool;                  // Factor after an acceptance.
+    const double heat;                  // Factor after a rejection.
+    double temp;
+
+public:
+    Adaptive(double init, double target, double rate = 0.01)
+        : Cooldown(init)
+        , cool(std::exp(-rate * (1. - target)))
+        , heat(std::exp(rate * target))
+        , temp(init)
+    {}
+    ~Adaptive() = default;
+
+    CooldownPtr clone(void) const override {
+        return std::make_shared<Adaptive>(*this);
+    }
+
+    double get_temp(unsigned) const override {
+        return temp;
+    }
+
+    void feedback(bool accepted, double gain) override {
+        if (gain < 0.) {
+            temp *= accepted ? cool : heat;
+        }
+    }
+};
+
+// Geometric cooling by `factor` per move, over the chains of a worker.
+// After `moves` moves in a row without an improvement the
+// temperature is raised back to a peak, which halves at every reheat.
+class hw2::BasicCD::Reheating final: public hw2::Cooldown {
+    const double alpha;
+    const unsigned patience;
+    double peak;
+    double temp;
+    unsigned stalled;
 
-    SolutionPtr sol_best = best;
-    double crit_best = best->criterion();
+public:
+    Reheating(double init, double factor, unsigned moves)
+        : Cooldown(init)
+        , alpha(factor)
+        , patience(moves)
+        , peak(init)
+        , temp(init)
+        , stalled(0u)
+    {}
+    ~Reheating() = default;
+
+    CooldownPtr clone(void) const override {
+        return std::make_shared<Reheating>(*this);
+    }
 
-    SolutionPtr sol_cur = best;
-    double crit_cur = crit_best;
+    double get_temp(unsigned) const override {
+        return temp;
+    }
 
-    unsigned not_improved = 0u;
+    void feedback(bool, double gain) override {
+        temp *= alpha;
 
-    for (unsigned it = 0u; not_improved < 10u; ++it) {
-        SolutionPtr sol_new = mutation->mutate(sol_cur);
-        double crit_new = sol_new->criterion();
+        if (gain > 0.) {
+            stalled = 0u;
+        } else if (++stalled >= patience) {
+            peak /= 2.;
+            temp = peak;
+            stalled = 0u;
+        }
+    }
+};
 
-        double temp = cooldown->get_temp(it);
-        double _diff = crit_cur - crit_new;
+// A precomputed schedule, held at its last value past the end.
+// Saves the `std::log` of the laws above on every move.
+class hw2::BasicCD::Table final: public hw2::Cooldown {
+    std::shared_ptr<const std::vector<double>> temps;   // Shared by clones.
 
-        if (_diff >= 0. || dist(rng) < std::exp(_diff / temp)) {
-            sol_cur = sol_new;
-            crit_cur = crit_new;
+public:
+    Table(std::vector<double> list)
+        : Cooldown(list.empty() ? 0. : list.front())
+        , temps(std::make_shared<const std::vector<double>>(std::move(list)))
+    {
+        if (temps->empty()) {
+            throw std::invalid_argument("empty cooldown table");
         }
+    }
+    ~Table() = default;
 
-        if (crit_cur < crit_best) {
-            sol_best = sol_cur;
-            crit_best = crit_cur;
-            not_improved = 0u;
-        } else {
-            ++not_improved;
+    // The first `n` temperatures of `law`.
+    static Table of(const Cooldown &law, unsigned n) {
+        std::vector<double> list(n);
+
+        for (unsigned it = 0u; it < n; ++it) {
+            list[it] = law.get_temp(it);
         }
+
+        return Table(std::move(list));
+    }
+
+    CooldownPtr clone(void) const override {
+        return std::make_shared<Table>(*this);
     }
 
-    std::lock_guard guard(mutex);
-    locals.emplace_back(std::move(sol_best));
+    double get_temp(unsigned it) const override {
+        return (*temps)[std::min<std::size_t>(it, temps->size() - 1u)];
+    }
+};
+
+hw2::Solution &hw2::Solution::operator=(const Solution &sol) {
+    restore(sol.score.load(std::memory_order_relaxed));
+    return *this;
 }
 
-hw2::SolutionPtr hw2::Annealing::run(SolutionPtr init) {
-    best = init;
-    double crit_best = best->criterion();
+double hw2::Solution::criterion(void) const {
+    double ans = score.load(std::memory_order_relaxed);
+
+    if (std::isnan(ans)) {
+        ans = evaluate();
+        score.store(ans, std::memory_order_relaxed);
+    }
 
-    SolutionPtr cur = best;
-    double crit_cur = crit_best;
+    return ans;
+}
 
-    unsigned not_improved = 0u;
+// Layout of a checkpoint file: this header, then the solution as
+// written by its `write`.
+struct hw2::CheckpointHeader {
+    static constexpr char signature[4] = {'H', 'W', '2', 'C'};
 
-    do {
-        for (auto &thr: threads) {
-            thr = std::thread(&Annealing::thread_payload, this);
+    char magic[4];
+    std::uint32_t not_improved;
+    std::uint64_t evaluations;
+    std::int64_t elapsed;           // In nanoseconds.
+    double criterion;
+};
+
+// Policies are consulted concurrently by all workers, so `done` must be
+// thread-safe.
+class hw2::Stopping {
+public:
+    virtual ~Stopping() = default;
+
+    virtual bool done(const Progress&) const = 0;
+};
+
+class hw2::BasicStop::Stall final: public hw2::Stopping {
+    const unsigned limit;
+
+public:
+    Stall(unsigned rounds): limit(rounds) {}
+    ~Stall() = default;
+
+    bool done(const Progress &prog) const override {
+        return prog.not_improved >= limit;
+    }
+};
+
+class hw2::BasicStop::Deadline final: public hw2::Stopping {
+    const Clock::duration limit;
+
+public:
+    Deadline(Clock::duration time): limit(time) {}
+    ~Deadline() = default;
+
+    bool done(const Progress &prog) const override {
+        return prog.elapsed >= limit;
+    }
+};
+
+class hw2::BasicStop::Evaluations final: public hw2::Stopping {
+    const unsigned long limit;
+
+public:
+    Evaluations(unsigned long evals): limit(evals) {}
+    ~Evaluations() = default;
+
+    bool done(const Progress &prog) const override {
+        return prog.evaluations >= limit;
+    }
+};
+
+class hw2::BasicStop::Target final: public hw2::Stopping {
+    const double target;
+
+public:
+    Target(double crit): target(crit) {}
+    ~Target() = default;
+
+    bool done(const Progress &prog) const override {
+        return prog.criterion <= target;
+    }
+};
+
+// Stops as soon as any of the policies does.
+class hw2::BasicStop::Any final: public hw2::Stopping {
+    const std::vector<StoppingPtr> policies;
+
+public:
+    Any(std::initializer_list<StoppingPtr> list): policies(list) {}
+    ~Any() = default;
+
+    bool done(const Progress &prog) const override {
+        return std::any_of(
+            policies.begin(), policies.end(),
+            [&prog](auto policy) { return policy->done(prog); }
+        );
+    }
+};
+
+// Value semantics over the polymorphic interfaces: copying a wrapper
+// clones the object behind it. Assigning a `SolutionRef` copies into
+// its solution in place when nobody else holds that one and it
+// supports `assign`.
+class hw2::SolutionRef {
+    friend class MutationRef;
+
+    SolutionPtr ptr;
+
+public:
+    SolutionRef(SolutionPtr sol): ptr(std::move(sol)) {}
+    SolutionRef(const SolutionRef &sol): ptr(sol.ptr->clone()) {}
+    SolutionRef(SolutionRef&&) = default;
+    SolutionRef &operator=(const SolutionRef &sol) {
+        if (!ptr || ptr.use_count() != 1 || !ptr->assign(*sol.ptr)) {
+            ptr = sol.ptr->clone();
         }
+        return *this;
+    }
+    SolutionRef &operator=(SolutionRef&&) = default;
+
+    double criterion(void) const { return ptr->criterion(); }
+    void commit(void) { ptr->commit(); }
+    void undo(void) { ptr->undo(); }
+    void write(std::ostream &out) const { ptr->write(out); }
+    void read(std::istream &in) { ptr->read(in); }
+    double lower_bound(void) const { return ptr->lower_bound(); }
+
+    SolutionPtr get(void) const { return ptr; }
+};
+
+class hw2::MutationRef {
+    MutationPtr ptr;
+
+public:
+    MutationRef(MutationPtr mut): ptr(std::move(mut)) {}
+    MutationRef(const MutationRef &mut): ptr(mut.ptr->clone()) {}
+    MutationRef(MutationRef&&) = default;
+    MutationRef &operator=(const MutationRef &mut) {
+        ptr = mut.ptr->clone();
+        return *this;
+    }
+    MutationRef &operator=(MutationRef&&) = default;
+
+    void propose(SolutionRef &sol, Random &rng) {
+        ptr->propose(*sol.ptr, rng);
+    }
+
+    void feedback(bool accepted, double gain) {
+        ptr->feedback(accepted, gain);
+    }
+};
+
+class hw2::CooldownRef {
+    CooldownPtr ptr;
+
+public:
+    CooldownRef(CooldownPtr cd): ptr(std::move(cd)) {}
+    CooldownRef(const CooldownRef &cd): ptr(cd.ptr->clone()) {}
+    CooldownRef(CooldownRef&&) = default;
+    CooldownRef &operator=(const CooldownRef &cd) {
+        ptr = cd.ptr->clone();
+        return *this;
+    }
+    CooldownRef &operator=(CooldownRef&&) = default;
+
+    double get_temp(unsigned it) const { return ptr->get_temp(it); }
+
+    void feedback(bool accepted, double gain) {
+        ptr->feedback(accepted, gain);
+    }
+};
+
+// The polymorphic engine, a thin adapter over `BasicAnnealing`.
+class hw2::Annealing:
+    public hw2::BasicAnnealing<SolutionRef, MutationRef, CooldownRef>
+{
+    using Base = BasicAnnealing<SolutionRef, MutationRef, CooldownRef>;
+
+public:
+    Annealing(
+        unsigned n_proc, MutationPtr mut, CooldownPtr cd,
+        Random::result_type seed = std::random_device{}()
+    )
+        : Base(n_proc, mut, cd, seed)
+    {}
+
+    SolutionPtr run(SolutionPtr init) {
+        return Base::run(init)->get();
+    }
+
+    SolutionPtr run(SolutionPtr init, StoppingPtr policy) {
+        return Base::run(init, policy)->get();
+    }
 
-        for (auto &thr: threads) {
-            thr.join();
+    SolutionPtr run_async(SolutionPtr init) {
+        return Base::run_async(init)->get();
+    }
+
+    SolutionPtr run_async(SolutionPtr init, StoppingPtr policy) {
+        return Base::run_async(init, policy)->get();
+    }
+
+    SolutionPtr run(const std::vector<SolutionPtr> &starts) {
+        return Base::run(refs(starts))->get();
+    }
+
+    SolutionPtr run(
+        const std::vector<SolutionPtr> &starts, StoppingPtr policy
+    )
+    {
+        return Base::run(refs(starts), policy)->get();
+    }
+
+    SolutionPtr run_async(const std::vector<SolutionPtr> &starts) {
+        return Base::run_async(refs(starts))->get();
+    }
+
+    SolutionPtr run_async(
+        const std::vector<SolutionPtr> &starts, StoppingPtr policy
+    )
+    {
+        return Base::run_async(refs(starts), policy)->get();
+    }
+
+private:
+    static std::vector<SolutionRef> refs(
+        const std::vector<SolutionPtr> &starts
+    )
+    {
+        return {starts.begin(), starts.end()};
+    }
+};
+
+// Apply a move to a copy of the solution.
+hw2::SolutionPtr hw2::Mutation::mutate(SolutionPtr sol, Random &rng) {
+    SolutionPtr ans = sol->clone();
+    propose(*ans, rng);
+    ans->commit();
+    return ans;
+}
+
+hw2::Workers::Workers(
+    unsigned n_proc,
+    Payload work,
+    Random::result_type seed
+)
+    : round(n_proc + 1u)
+    , payload(std::move(work))
+    , stopping(false)
+{
+    Random seeds(seed);
+
+    for (unsigned id = 0u; id < n_proc; ++id) {
+        threads.emplace_back(&Workers::worker, this, id, seeds());
+    }
+}
+
+hw2::Workers::~Workers() {
+    stopping = true;
+    round.arrive_and_wait();
+
+    for (auto &thr: threads) {
+        thr.join();
+    }
+}
+
+void hw2::Workers::worker(unsigned id, Random::result_type seed) {
+    Random rng(seed);
+
+    while (true) {
+        round.arrive_and_wait();
+
+        if (stopping) {
+            return;
         }
 
-        cur = *std::min_element(
+        payload(id, rng);
+        round.arrive_and_wait();
+    }
+}
+
+hw2::Budget::Budget(void)
+    : stop(nullptr)
+    , start(Clock::now())
+    , crit_global(std::numeric_limits<double>::infinity())
+    , evaluations(0ul)
+    , stall(0u)
+    , finished(false)
+    , bound(-std::numeric_limits<double>::infinity())
+{}
+
+// Start a run from criterion `crit`, with lower bound `lower`.
+// The counters start from `base`, e.g. when resuming.
+void hw2::Budget::begin(
+    StoppingPtr policy,
+    double crit,
+    double lower,
+    Progress base
+)
+{
+    stop = policy;
+    start.store(Clock::now() - base.elapsed);
+    crit_global.store(crit);
+    evaluations.store(base.evaluations);
+    stall.store(base.not_improved);
+    finished.store(false);
+    bound = lower;
+}
+
+// Check the stopping policy and the bound, the answer sticks until
+// the next run.
+bool hw2::Budget::exhausted(void) {
+    if (
+        !finished.load(std::memory_order_relaxed)
+        && (
+            crit_global.load(std::memory_order_relaxed) <= bound
+            || stop->done(progress())
+        )
+    ) {
+        finished.store(true, std::memory_order_relaxed);
+    }
+
+    return finished.load(std::memory_order_relaxed);
+}
+
+// Count a round that ended at `crit`, return whether it is a new best.
+bool hw2::Budget::tally(double crit) {
+    if (crit < crit_global.load(std::memory_order_relaxed)) {
+        crit_global.store(crit, std::memory_order_relaxed);
+        stall.store(0u, std::memory_order_relaxed);
+        return true;
+    }
+
+    stall.fetch_add(1u, std::memory_order_relaxed);
+    return false;
+}
+
+// Add `evals` to the count, return whether the run must stop.
+bool hw2::Budget::charge(unsigned evals) {
+    evaluations.fetch_add(evals, std::memory_order_relaxed);
+    return exhausted();
+}
+
+// Stop the run if `crit` reaches the lower bound, return whether it
+// does.
+bool hw2::Budget::reached(double crit) {
+    if (crit > bound) {
+        return false;
+    }
+
+    finished.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+hw2::Progress hw2::Budget::progress(void) const {
+    return {
+        evaluations.load(std::memory_order_relaxed),
+        crit_global.load(std::memory_order_relaxed),
+        stall.load(std::memory_order_relaxed),
+        Clock::now() - start.load(std::memory_order_relaxed)
+    };
+}
+
+// How far the best solution so far may be from optimal: zero once it
+// reaches the lower bound, infinite without one.
+double hw2::Budget::gap(void) const {
+    return crit_global.load(std::memory_order_relaxed) - bound;
+}
+
+// Stop the run in progress as soon as the workers notice, as though its
+// policy did. Safe to call from any thread, the observer included.
+// Has no effect on a run started later.
+void hw2::Budget::request_stop(void) {
+    finished.store(true, std::memory_order_relaxed);
+}
+
+// Run rounds on `crew` until the run is exhausted. Worker `id` starts
+// from `locals[id]` and replaces it with its result. After a round the
+// best result is tallied and replaces `best` if it beats it, then
+// `after(improved, best)` is called, and the next round starts from
+// `best` everywhere. Returns the best solution of the run.
+template<class P, class F>
+P hw2::Budget::drive(Workers &crew, std::vector<P> &locals, P best, F after)
+{
+    do {
+        crew.run();
+
+        P cur = *std::min_element(
             locals.begin(), locals.end(),
             [](auto s1, auto s2) { return s1->criterion() < s2->criterion(); }
         );
-        crit_cur = cur->criterion();
+        bool improved = tally(cur->criterion());
 
-        if (crit_cur < crit_best) {
+        if (improved) {
             best = cur;
-            crit_best = crit_cur;
-            not_improved = 0u;
+        }
+
+        after(improved, best);
+        std::fill(locals.begin(), locals.end(), best);
+    } while (!exhausted());
+
+    return best;
+}
+
+template<class S, class M, class C>
+hw2::Chain<S, M, C>::Chain(
+    S &start,
+    M &mutation,
+    C &cooldown,
+    Random &gen,
+    double lower,
+    bool timing
+)
+    : sol(start)
+    , mut(mutation)
+    , cool(cooldown)
+    , rng(gen)
+    , dist(0., 1.)
+    , bound(lower)
+    , profile(timing)
+    , crit_cur(start.criterion())
+    , crit_best(crit_cur)
+    , temp(cooldown.get_temp(0u))
+    , it(0u)
+    , not_improved(0u)
+    , cnt{}
+{}
+
+// Propose a move, then commit or undo it. Returns whether the chain
+// found a new best, which `sol` then is.
+template<class S, class M, class C>
+bool hw2::Chain<S, M, C>::step(void) {
+    double crit_new;
+
+    if (profile) {
+        auto time_start = Clock::now();
+        mut.propose(sol, rng);
+        auto time_mid = Clock::now();
+        crit_new = sol.criterion();
+        cnt.mutate += time_mid - time_start;
+        cnt.evaluate += Clock::now() - time_mid;
+    } else {
+        mut.propose(sol, rng);
+        crit_new = sol.criterion();
+    }
+
+    temp = cool.get_temp(it++);
+    double _diff = crit_cur - crit_new;
+    bool accepted = _diff >= 0. || dist(rng) < std::exp(_diff / temp);
+    ++cnt.iterations;
+
+    if (accepted) {
+        sol.commit();
+        crit_cur = crit_new;
+        ++cnt.accepted;
+        cnt.uphill += _diff < 0.;
+    } else {
+        sol.undo();
+    }
+
+    if constexpr (requires { mut.feedback(accepted, _diff); }) {
+        mut.feedback(accepted, _diff);
+    }
+
+    if constexpr (requires { cool.feedback(accepted, _diff); }) {
+        cool.feedback(accepted, _diff);
+    }
+
+    if (crit_cur < crit_best) {
+        crit_best = crit_cur;
+        not_improved = 0u;
+        return true;
+    }
+
+    ++not_improved;
+    return false;
+}
+
+// Worker generators are seeded from `seed`, so that a run started
+// from the same solution with the same seed is reproduced exactly.
+template<class S, class M, class C>
+hw2::BasicAnnealing<S, M, C>::BasicAnnealing(
+    unsigned n_proc,
+    M mut,
+    C cd,
+    Random::result_type seed
+)
+    : locals(n_proc)
+    , slots(n_proc)
+    , best(nullptr)
+    , mutation(std::move(mut))
+    , cooldown(std::move(cd))
+    , async(false)
+    , profile(false)
+    , trace_period(0u)
+    , obs_period(Clock::duration::zero())
+    , ckpt_period(Clock::duration::zero())
+    , writing(false)
+    , crew(
+        n_proc, [this](unsigned id, Random &rng) { worker(id, rng); }, seed
+    )
+{}
+
+template<class S, class M, class C>
+hw2::BasicAnnealing<S, M, C>::~BasicAnnealing() {
+    if (writer.joinable()) {
+        writer.join();
+    }
+}
+
+// One round of worker `id`.
+template<class S, class M, class C>
+void hw2::BasicAnnealing<S, M, C>::worker(unsigned id, Random &rng) {
+    Slot &slot = slots[id];
+
+    if (async) {
+        async_payload(locals[id], *slot.mut, *slot.cool, rng, slot);
+    } else {
+        locals[id] = thread_payload(
+            locals[id], *slot.mut, *slot.cool, rng, slot
+        );
+    }
+
+    slot.done = Clock::now();
+}
+
+// Anneal from `init` until the chain stalls, return its best solution.
+template<class S, class M, class C>
+hw2::BasicAnnealing<S, M, C>::Snapshot
+hw2::BasicAnnealing<S, M, C>::thread_payload(
+    Snapshot init,
+    M &mut,
+    C &cool,
+    Random &rng,
+    Slot &slot
+)
+{
+    Snapshot sol_best = init;
+
+    if (slot.scratch) {
+        *slot.scratch = *init;
+    } else {
+        slot.scratch.emplace(*init);
+    }
+
+    S &sol_cur = *slot.scratch;
+    Chain chain(sol_cur, mut, cool, rng, bound, profile);
+    unsigned pending = 0u;              // Not yet added to `evaluations`.
+
+    for (; !chain.done(); ++pending) {
+        if (pending == check_period) {
+            slot.temp.store(chain.temperature(), std::memory_order_relaxed);
+            bool done = charge(pending);
+            pending = 0u;
+
+            if (done) {
+                break;
+            }
+        }
+
+        // The chain stops by itself at the bound.
+        if (chain.step()) {
+            sol_best = slot.pool.copy(sol_cur);
+            reached(chain.best());
+        }
+
+        unsigned long step = slot.counters.iterations
+                           + chain.counters().iterations;
+
+        if (trace_period && step % trace_period == 0u) {
+            slot.trace.push_back({
+                0u, step, Clock::now() - start.load(), chain.temperature(),
+                chain.current(), chain.best()
+            });
+        }
+    }
+
+    charge(pending);
+    slot.temp.store(chain.temperature(), std::memory_order_relaxed);
+    slot.counters += chain.counters();
+    return sol_best;
+}
+
+// Run chains back to back: the first one from `init`, each of the
+// others from the latest global best.
+template<class S, class M, class C>
+void hw2::BasicAnnealing<S, M, C>::async_payload(
+    Snapshot init,
+    M &mut,
+    C &cool,
+    Random &rng,
+    Slot &slot
+)
+{
+    while (!exhausted()) {
+        rounds.fetch_add(1u, std::memory_order_relaxed);
+
+        if (publish(thread_payload(init, mut, cool, rng, slot))) {
+            stall.store(0u, std::memory_order_relaxed);
         } else {
-            ++not_improved;
+            stall.fetch_add(1u, std::memory_order_relaxed);
         }
 
-        locals.clear();
-    } while (not_improved < 10u);
+        init = global.load();
+    }
+}
+
+// Make `sol` the global best if it beats the current one.
+// `crit_global` lets most candidates be rejected without touching `global`.
+template<class S, class M, class C>
+bool hw2::BasicAnnealing<S, M, C>::publish(Snapshot sol) {
+    double crit = sol->criterion();
+
+    if (crit >= crit_global.load(std::memory_order_relaxed)) {
+        return false;
+    }
+
+    Snapshot cur = global.load();
 
+    do {
+        if (crit >= cur->criterion()) {
+            return false;
+        }
+    } while (!global.compare_exchange_weak(cur, sol));
+
+    double prev = crit_global.load(std::memory_order_relaxed);
+
+    while (crit < prev && !crit_global.compare_exchange_weak(prev, crit)) {}
+
+    return true;
+}
+
+// Worker `id` starts from `starts[id % starts.size()]`.
+// The counters start from `base`, e.g. when resuming.
+template<class S, class M, class C>
+void hw2::BasicAnnealing<S, M, C>::prepare(
+    std::vector<S> &&starts,
+    StoppingPtr policy,
+    Progress base
+)
+{
+    if (starts.empty()) {
+        throw std::invalid_argument("no initial solution");
+    }
+
+    std::vector<Snapshot> snaps;
+
+    for (auto &init: starts) {
+        snaps.push_back(std::make_shared<const S>(std::move(init)));
+    }
+
+    for (unsigned id = 0u; id < locals.size(); ++id) {
+        locals[id] = snaps[id % snaps.size()];
+    }
+
+    best = *std::min_element(
+        snaps.begin(), snaps.end(),
+        [](auto s1, auto s2) { return s1->criterion() < s2->criterion(); }
+    );
+    double lower = -std::numeric_limits<double>::infinity();
+
+    if constexpr (requires { best->lower_bound(); }) {
+        lower = best->lower_bound();
+    }
+
+    begin(policy, best->criterion(), lower, base);
+    global.store(best);
+    rounds.store(0u);
+    ckpt_last = Clock::now();
+    obs_last = ckpt_last;
+    failure = nullptr;
+
+    for (auto &slot: slots) {
+        slot.counters = {};
+        slot.trace.clear();
+        slot.mut.emplace(mutation);
+        slot.cool.emplace(cooldown);
+    }
+}
+
+// Charge every worker for the time it spent waiting on the others,
+// called by the coordinator once a round is over.
+template<class S, class M, class C>
+void hw2::BasicAnnealing<S, M, C>::collect(void) {
+    auto now = Clock::now();
+
+    for (auto &slot: slots) {
+        slot.counters.wait += now - slot.done;
+    }
+}
+
+template<class S, class M, class C>
+void hw2::BasicAnnealing<S, M, C>::gather(void) {
+    stats.workers.clear();
+    stats.trace.clear();
+
+    for (unsigned id = 0u; id < slots.size(); ++id) {
+        stats.workers.push_back(slots[id].counters);
+
+        for (auto sample: slots[id].trace) {
+            sample.worker = id;
+            stats.trace.push_back(sample);
+        }
+    }
+
+    std::sort(
+        stats.trace.begin(), stats.trace.end(),
+        [](auto s1, auto s2) { return s1.elapsed < s2.elapsed; }
+    );
+}
+
+// Time the moves if `timing` is set, and sample the chain of every
+// worker each `period` of its steps if `period` is not zero.
+// Applies from the next run on, and must not be called during one.
+template<class S, class M, class C>
+void hw2::BasicAnnealing<S, M, C>::instrument(bool timing, unsigned period) {
+    profile = timing;
+    trace_period = period;
+}
+
+// Safe to call from any thread, also during a run. Only reads what
+// the workers publish anyway, and a temperature they sample once per
+// `check_period` steps, so it does not slow them down.
+template<class S, class M, class C>
+hw2::BasicAnnealing<S, M, C>::Report
+hw2::BasicAnnealing<S, M, C>::snapshot(void) const {
+    Report ans = {
+        progress(), rounds.load(std::memory_order_relaxed), {}, global.load()
+    };
+
+    for (const auto &slot: slots) {
+        ans.temperatures.push_back(
+            slot.temp.load(std::memory_order_relaxed)
+        );
+    }
+
+    return ans;
+}
+
+// Call `obs` with a report at most once per `period`, from the thread
+// that runs. It is called between rounds, so a run with long rounds
+// reports less often, and never more often than every `poll_period`.
+// An empty observer turns reports off. Must not be called during a run.
+template<class S, class M, class C>
+void hw2::BasicAnnealing<S, M, C>::observe(
+    Observer obs,
+    Clock::duration period
+)
+{
+    observer = std::move(obs);
+    obs_period = std::max(period, poll_period);
+}
+
+template<class S, class M, class C>
+void hw2::BasicAnnealing<S, M, C>::notify(void) {
+    auto now = Clock::now();
+
+    if (!observer || now - obs_last < obs_period) {
+        return;
+    }
+
+    obs_last = now;
+    observer(snapshot());
+}
+
+// Stops after 10 rounds in a row without a new best.
+template<class S, class M, class C>
+hw2::BasicAnnealing<S, M, C>::Snapshot
+hw2::BasicAnnealing<S, M, C>::run(S init) {
+    return run(std::move(init), std::make_shared<BasicStop::Stall>(10u));
+}
+
+template<class S, class M, class C>
+hw2::BasicAnnealing<S, M, C>::Snapshot
+hw2::BasicAnnealing<S, M, C>::run(S init, StoppingPtr policy) {
+    std::vector<S> starts;
+    starts.push_back(std::move(init));
+    return run(std::move(starts), policy);
+}
+
+// Multi-start run: the workers start the first round from different
+// solutions, e.g. built by different strategies, and every later round
+// from the best found so far.
+template<class S, class M, class C>
+hw2::BasicAnnealing<S, M, C>::Snapshot
+hw2::BasicAnnealing<S, M, C>::run(std::vector<S> starts) {
+    return run(std::move(starts), std::make_shared<BasicStop::Stall>(10u));
+}
+
+// Anytime run: when the policy stops it, the best solution found
+// up to that moment is returned.
+template<class S, class M, class C>
+hw2::BasicAnnealing<S, M, C>::Snapshot
+hw2::BasicAnnealing<S, M, C>::run(
+    std::vector<S> starts,
+    StoppingPtr policy
+)
+{
+    prepare(std::move(starts), policy);
+    return run_rounds();
+}
+
+template<class S, class M, class C>
+hw2::BasicAnnealing<S, M, C>::Snapshot
+hw2::BasicAnnealing<S, M, C>::run_rounds(void) {
+    best = drive(crew, locals, best, [this](bool improved, Snapshot cur) {
+        collect();
+        rounds.fetch_add(1u, std::memory_order_relaxed);
+
+        if (improved) {
+            global.store(cur);
+        }
+
+        save(cur);
+        notify();
+    });
+
+    gather();
+    global.store(nullptr);
+    finish_save();
     return best;
 }
 
+// Stops after `10 * n_proc` chains in a row without a new best,
+// the same budget the synchronous run allows.
+template<class S, class M, class C>
+hw2::BasicAnnealing<S, M, C>::Snapshot
+hw2::BasicAnnealing<S, M, C>::run_async(S init) {
+    return run_async(
+        std::move(init),
+        std::make_shared<BasicStop::Stall>(10u * crew.size())
+    );
+}
+
+template<class S, class M, class C>
+hw2::BasicAnnealing<S, M, C>::Snapshot
+hw2::BasicAnnealing<S, M, C>::run_async(S init, StoppingPtr policy) {
+    std::vector<S> starts;
+    starts.push_back(std::move(init));
+    return run_async(std::move(starts), policy);
+}
+
+template<class S, class M, class C>
+hw2::BasicAnnealing<S, M, C>::Snapshot
+hw2::BasicAnnealing<S, M, C>::run_async(std::vector<S> starts) {
+    return run_async(
+        std::move(starts),
+        std::make_shared<BasicStop::Stall>(10u * crew.size())
+    );
+}
+
+// Anneal without rounds: the workers never wait for each other.
+// Each one runs its first chain from its own starting point.
+template<class S, class M, class C>
+hw2::BasicAnnealing<S, M, C>::Snapshot
+hw2::BasicAnnealing<S, M, C>::run_async(
+    std::vector<S> starts,
+    StoppingPtr policy
+)
+{
+    prepare(std::move(starts), policy);
+    return run_free();
+}
+
+template<class S, class M, class C>
+hw2::BasicAnnealing<S, M, C>::Snapshot
+hw2::BasicAnnealing<S, M, C>::run_free(void) {
+    async = true;
+    crew.launch();
+
+    // Often enough to notice the end of the run soon.
+    while (
+        (!ckpt_path.empty() || observer)
+        && !finished.load(std::memory_order_relaxed)
+    ) {
+        std::this_thread::sleep_for(poll_period);
+        save(global.load());
+        notify();
+    }
+
+    crew.wait();
+    async = false;
+
+    collect();
+    gather();
+    best = global.exchange(nullptr);
+    finish_save();
+    return best;
+}
+
+// Continue the run saved at `path`: `init` is any solution of the same
+// problem, its state is replaced by the saved one. The counters carry
+// on from their saved values, the policy applies to the whole run.
+// The mutations and cooldowns of the workers start afresh, as on every
+// run, and the generators don't, so the continuation is not the same as
+// an uninterrupted run.
+template<class S, class M, class C>
+hw2::BasicAnnealing<S, M, C>::Snapshot
+hw2::BasicAnnealing<S, M, C>::resume(
+    const std::filesystem::path &path,
+    S init,
+    StoppingPtr policy
+)
+{
+    Progress base = load(path, init);
+    std::vector<S> starts;
+    starts.push_back(std::move(init));
+
+    prepare(std::move(starts), policy, base);
+    return run_rounds();
+}
+
+template<class S, class M, class C>
+hw2::BasicAnnealing<S, M, C>::Snapshot
+hw2::BasicAnnealing<S, M, C>::resume_async(
+    const std::filesystem::path &path,
+    S init,
+    StoppingPtr policy
+)
+{
+    Progress base = load(path, init);
+    std::vector<S> starts;
+    starts.push_back(std::move(init));
+
+    prepare(std::move(starts), policy, base);
+    return run_free();
+}
+
+// Save to `path` at most once per `period`, and never more often than
+// every `poll_period`. An empty path turns checkpoints off. The path is
+// checked to be writable right away, so that a run doesn't go without
+// checkpoints by mistake. Must not be called during a run.
+template<class S, class M, class C>
+void hw2::BasicAnnealing<S, M, C>::checkpoint(
+    const std::filesystem::path &path,
+    Clock::duration period
+)
+{
+    if constexpr (!requires (const S &sol, std::ostream &out) {
+        sol.write(out);
+    }) {
+        if (!path.empty()) {
+            throw std::invalid_argument("checkpoints not supported");
+        }
+    }
+
+    if (!path.empty()) {
+        auto tmp = path;
+        tmp += ".tmp";
+
+        if (!std::ofstream(tmp, std::ios::binary).is_open()) {
+            throw std::invalid_argument("can't open file");
+        }
+
+        std::filesystem::remove(tmp);
+    }
+
+    ckpt_path = path;
+    ckpt_period = std::max(period, poll_period);
+}
+
+// Hand `sol` to the writer if a checkpoint is due and the previous one
+// is done. The file is written next to `path` and renamed over it, so
+// a crash while writing leaves the previous checkpoint intact.
+template<class S, class M, class C>
+void hw2::BasicAnnealing<S, M, C>::save(Snapshot sol) {
+    auto now = Clock::now();
+
+    if (
+        ckpt_path.empty()
+        || now - ckpt_last < ckpt_period
+        || writing.load(std::memory_order_acquire)
+    ) {
+        return;
+    }
+
+    if (writer.joinable()) {
+        writer.join();
+    }
+
+    ckpt_last = now;
+    writing.store(true, std::memory_order_relaxed);
+
+    CheckpointHeader header = {
+        {},
+        stall.load(std::memory_order_relaxed),
+        evaluations.load(std::memory_order_relaxed),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            now - start.load()
+        ).count(),
+        sol->criterion()
+    };
+    std::memcpy(
+        header.magic, CheckpointHeader::signature, sizeof(header.magic)
+    );
+
+    writer = std::thread([this, sol, header] {
+        try {
+            auto tmp = ckpt_path;
+            tmp += ".tmp";
+            std::ofstream file(tmp, std::ios::binary);
+
+            if (!file.is_open()) {
+                throw std::invalid_argument("can't open file");
+            }
+
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+            // Always true, `checkpoint` refuses an `S` without `write`.
+            if constexpr (requires { sol->write(file); }) {
+                sol->write(file);
+            }
+
+            file.close();
+
+            if (!file) {
+                throw std::invalid_argument("can't write file");
+            }
+
+            std::filesystem::rename(tmp, ckpt_path);
+        } catch (...) {
+            // Read by the coordinator only after joining the writer.
+            if (!failure) {
+                failure = std::current_exception();
+            }
+        }
+
+        writing.store(false, std::memory_order_release);
+    });
+}
+
+// Wait for the last checkpoint, its failure if any is then visible to
+// `checkpoint_error`.
+template<class S, class M, class C>
+void hw2::BasicAnnealing<S, M, C>::finish_save(void) {
+    if (writer.joinable()) {
+        writer.join();
+    }
+}
+
+// Read the checkpoint at `path` into `sol`, return the saved counters.
+template<class S, class M, class C>
+hw2::Progress hw2::BasicAnnealing<S, M, C>::load(
+    const std::filesystem::path &path,
+    S &sol
+)
+{
+    std::ifstream file(path, std::ios::binary);
+
+    if (!file.is_open()) {
+        throw std::invalid_argument("can't open file");
+    }
+
+    CheckpointHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    if (
+        !file
+        || std::memcmp(
+            header.magic, CheckpointHeader::signature, sizeof(header.magic)
+        )
+    ) {
+        throw std::invalid_argument("bad checkpoint file");
+    }
+
+    if constexpr (requires { sol.read(file); }) {
+        sol.read(file);
+    } else {
+        throw std::invalid_argument("checkpoints not supported");
+    }
+
+    return {
+        header.evaluations,
+        header.criterion,
+        header.not_improved,
+        std::chrono::nanoseconds(header.elapsed)
+    };
+}
+
 #endif // _HW2_ANNEALING_H
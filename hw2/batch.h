@@ -0,0 +1,343 @@
+#ifndef _HW2_BATCH_H
+#define _HW2_BATCH_H
+
+#include "annealing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace hw2 {
+    template<class S, class M, class C>
+    class Batch;
+} // namespace hw2
+
+// Solves many independent instances at once, each on a single thread.
+// `S`, `M` and `C` are as in `BasicAnnealing`, every instance comes
+// with its own cooldown and stopping policy.
+//
+// Every worker owns a queue: it takes instances from the front of its
+// own and, once it runs dry, steals from the back of the others'.
+// An instance is submitted to the shortest queue. Taking one locks only
+// the queue it is in, the shared lock is for handing in results and
+// for the workers that find every queue empty and go to sleep.
+// Results are handed out by `next` in the order they are ready.
+template<class S, class M, class C>
+class hw2::Batch {
+public:
+    using Snapshot = std::shared_ptr<const S>;
+
+    struct Result {
+        unsigned long id;               // As returned by `submit`.
+        Snapshot best;
+        Progress progress;              // At the end of the run.
+        double gap;                     // To the lower bound, if any.
+    };
+
+private:
+    struct Job {
+        unsigned long id;
+        S init;
+        C cooldown;
+        StoppingPtr stop;
+    };
+
+    struct Queue {
+        std::mutex lock;
+        std::deque<Job> jobs;
+        std::atomic<std::size_t> size;  // Of `jobs`, read without `lock`.
+    };
+
+    std::vector<std::thread> threads;
+    std::vector<Queue> queues;          // One per worker.
+    M mutation;
+    Random::result_type seed;
+    std::atomic<long> queued;           // Not yet taken by a worker,
+                                        // counted after the fact.
+    std::atomic<bool> stopping;
+
+    std::mutex lock;                    // Guards everything below, and
+                                        // increments of `queued`.
+    std::condition_variable work;       // Signalled on submission.
+    std::condition_variable done;       // Signalled on a result.
+    std::deque<Result> results;
+    unsigned long submitted;
+    unsigned long outstanding;          // Not yet returned by `next`.
+
+    void worker(unsigned);
+    std::optional<Job> take(unsigned);
+    Result solve(Job&);
+    Snapshot chain(
+        Snapshot, M&, C&, Random&, Progress&, const Stopping&,
+        Clock::time_point, double
+    );
+
+public:
+    Batch(unsigned, M, Random::result_type = std::random_device{}());
+    Batch(const Batch&) = delete;
+    Batch &operator=(const Batch&) = delete;
+    ~Batch();
+
+    unsigned long submit(S, C);
+    unsigned long submit(S, C, StoppingPtr);
+    std::optional<Result> next(void);
+};
+
+template<class S, class M, class C>
+hw2::Batch<S, M, C>::Batch(
+    unsigned n_proc,
+    M mut,
+    Random::result_type base
+)
+    : queues(n_proc)
+    , mutation(std::move(mut))
+    , seed(base)
+    , queued(0l)
+    , stopping(false)
+    , submitted(0ul)
+    , outstanding(0ul)
+{
+    if (!n_proc) {
+        throw std::invalid_argument("no workers");
+    }
+
+    for (auto &queue: queues) {
+        queue.size.store(0u, std::memory_order_relaxed);
+    }
+
+    for (unsigned id = 0u; id < n_proc; ++id) {
+        threads.emplace_back(&Batch::worker, this, id);
+    }
+}
+
+// Instances still queued are dropped, those being solved are finished.
+template<class S, class M, class C>
+hw2::Batch<S, M, C>::~Batch() {
+    {
+        std::lock_guard guard(lock);
+        stopping.store(true, std::memory_order_relaxed);
+    }
+    work.notify_all();
+
+    for (auto &thr: threads) {
+        thr.join();
+    }
+}
+
+// Sleeps only once every queue is empty. A submission counts in
+// `queued` under `lock` before it is signalled, so it can't be missed.
+template<class S, class M, class C>
+void hw2::Batch<S, M, C>::worker(unsigned id) {
+    while (!stopping.load(std::memory_order_relaxed)) {
+        if (std::optional<Job> job = take(id)) {
+            Result res = solve(*job);
+
+            {
+                std::lock_guard guard(lock);
+                results.push_back(std::move(res));
+            }
+            done.notify_one();
+            continue;
+        }
+
+        std::unique_lock guard(lock);
+        work.wait(guard, [this] {
+            return stopping.load(std::memory_order_relaxed)
+                || queued.load(std::memory_order_relaxed) > 0l;
+        });
+    }
+}
+
+// The front of the own queue, or else the back of another one, nothing
+// if all are empty. Empty queues are skipped without locking them.
+template<class S, class M, class C>
+std::optional<typename hw2::Batch<S, M, C>::Job>
+hw2::Batch<S, M, C>::take(unsigned id) {
+    for (unsigned i = 0u; i < queues.size(); ++i) {
+        Queue &queue = queues[(id + i) % queues.size()];
+
+        if (!queue.size.load(std::memory_order_relaxed)) {
+            continue;
+        }
+
+        std::lock_guard guard(queue.lock);
+
+        if (queue.jobs.empty()) {
+            continue;
+        }
+
+        std::optional<Job> job(
+            std::in_place,
+            std::move(i ? queue.jobs.back() : queue.jobs.front())
+        );
+
+        if (i) {
+            queue.jobs.pop_back();
+        } else {
+            queue.jobs.pop_front();
+        }
+
+        queue.size.store(queue.jobs.size(), std::memory_order_relaxed);
+        queued.fetch_sub(1l, std::memory_order_relaxed);
+        return job;
+    }
+
+    return std::nullopt;
+}
+
+// Anneal on the calling thread, chain after chain from the best
+// solution so far, until the policy stops it or the lower bound is
+// reached. The generator is seeded from the id, so the result does not
+// depend on the worker.
+template<class S, class M, class C>
+hw2::Batch<S, M, C>::Result hw2::Batch<S, M, C>::solve(Job &job) {
+    Random rng(Random::mix(seed) + job.id);
+    M mut = mutation;
+    C &cool = job.cooldown;
+
+    Snapshot best = std::make_shared<const S>(std::move(job.init));
+    Progress prog = {0ul, best->criterion(), 0u, {}};
+    auto start = Clock::now();
+    double bound = -std::numeric_limits<double>::infinity();
+
+    if constexpr (requires { best->lower_bound(); }) {
+        bound = best->lower_bound();
+    }
+
+    while (prog.criterion > bound && !job.stop->done(prog)) {
+        Snapshot cur = chain(
+            best, mut, cool, rng, prog, *job.stop, start, bound
+        );
+
+        if (cur->criterion() < prog.criterion) {
+            best = cur;
+            prog.criterion = cur->criterion();
+            prog.not_improved = 0u;
+        } else {
+            ++prog.not_improved;
+        }
+
+        prog.elapsed = Clock::now() - start;
+    }
+
+    return {job.id, best, prog, prog.criterion - bound};
+}
+
+// Same chain as a worker of `BasicAnnealing` runs.
+template<class S, class M, class C>
+hw2::Batch<S, M, C>::Snapshot hw2::Batch<S, M, C>::chain(
+    Snapshot init,
+    M &mut,
+    C &cool,
+    Random &rng,
+    Progress &prog,
+    const Stopping &stop,
+    Clock::time_point start,
+    double bound
+)
+{
+    Snapshot sol_best = init;
+    S sol_cur = *init;
+    Chain chain(sol_cur, mut, cool, rng, bound);
+
+    for (unsigned it = 0u; !chain.done(); ++it) {
+        if (it && it % Budget::check_period == 0u) {
+            prog.elapsed = Clock::now() - start;
+
+            if (stop.done(prog)) {
+                break;
+            }
+        }
+
+        ++prog.evaluations;
+
+        if (chain.step()) {
+            sol_best = std::make_shared<const S>(sol_cur);
+        }
+    }
+
+    return sol_best;
+}
+
+// Stops after 10 chains in a row without a new best.
+template<class S, class M, class C>
+unsigned long hw2::Batch<S, M, C>::submit(S init, C cd) {
+    return submit(
+        std::move(init), std::move(cd),
+        std::make_shared<BasicStop::Stall>(10u)
+    );
+}
+
+// Queue an instance, return the id its result will carry.
+template<class S, class M, class C>
+unsigned long hw2::Batch<S, M, C>::submit(
+    S init,
+    C cd,
+    StoppingPtr policy
+)
+{
+    unsigned long id;
+
+    {
+        std::lock_guard guard(lock);
+        id = submitted++;
+        ++outstanding;
+    }
+
+    auto shortest = std::min_element(
+        queues.begin(), queues.end(),
+        [](const Queue &q1, const Queue &q2) {
+            return q1.size.load(std::memory_order_relaxed)
+                 < q2.size.load(std::memory_order_relaxed);
+        }
+    );
+
+    {
+        std::lock_guard guard(shortest->lock);
+        shortest->jobs.push_back(
+            {id, std::move(init), std::move(cd), policy}
+        );
+        shortest->size.store(
+            shortest->jobs.size(), std::memory_order_relaxed
+        );
+    }
+
+    {
+        std::lock_guard guard(lock);
+        queued.fetch_add(1l, std::memory_order_relaxed);
+    }
+    work.notify_one();
+
+    return id;
+}
+
+// Wait for the next finished instance, in no particular order.
+// Returns nothing once every submitted instance has been returned.
+template<class S, class M, class C>
+std::optional<typename hw2::Batch<S, M, C>::Result>
+hw2::Batch<S, M, C>::next(void) {
+    std::unique_lock guard(lock);
+
+    if (!outstanding) {
+        return std::nullopt;
+    }
+
+    done.wait(guard, [this] { return !results.empty(); });
+
+    Result res = std::move(results.front());
+    results.pop_front();
+    --outstanding;
+
+    return res;
+}
+
+#endif // _HW2_BATCH_H
@@ -0,0 +1,297 @@
+#include "generate.h"
+#include "local.h"
+#include "scheduling.h"
+#include "tempering.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Median and range of a measured value over the trials.
+struct Summary {
+    double median;
+    double min;
+    double max;
+};
+
+struct Result {
+    unsigned procs;
+    unsigned works;
+    unsigned threads;
+    const char *law;
+    unsigned trials;
+    Summary time;                       // Seconds per run.
+    Summary criterion;                  // Of the best solution.
+    Summary rate;                       // Evaluations per second.
+};
+
+// Best criterion and number of evaluations of a run.
+using Outcome = std::pair<double, unsigned long>;
+using Run = std::function<Outcome(void)>;
+
+Summary summarize(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    std::size_t mid = values.size() / 2u;
+    double median = values.size() % 2u
+        ? values[mid]
+        : (values[mid - 1u] + values[mid]) / 2.;
+
+    return {median, values.front(), values.back()};
+}
+
+std::vector<unsigned> parse_list(const char *arg) {
+    std::vector<unsigned> ans;
+    char *end;
+
+    do {
+        ans.push_back(std::strtoul(arg, &end, 10));
+        arg = end + 1;
+    } while (*end == ',');
+
+    return ans;
+}
+
+// Trial `i` of every configuration with the same processor and work
+// counts solves the same instance, from the same initial solution.
+// The seeds of the instance, of the initial solution and of the engine
+// are drawn from a generator seeded with `seed` and `i`.
+// `prepare(init, threads, seed)` builds the engine, so that starting its
+// threads isn't timed, and returns the run to time.
+template<class Prepare>
+Result measure(
+    const char *name,
+    unsigned procs,
+    unsigned works,
+    unsigned threads,
+    unsigned trials,
+    hw2::Random::result_type seed,
+    Prepare prepare
+)
+{
+    std::vector<double> times, crits, rates;
+
+    for (unsigned trial = 0u; trial < trials; ++trial) {
+        hw2::Random seeds(hw2::Random::mix(seed) + trial);
+        auto inst = std::make_shared<const Scheduling::Instance>(
+            procs,
+            hw2::DataGenerator(
+                procs, works, 1u, 128u,
+                hw2::DataGenerator::Law::Uniform, seeds()
+            ).generate()
+        );
+        hw2::Random rng(seeds());
+        Scheduling::Solution init(inst, rng);
+        Run run = prepare(init, threads, seeds());
+
+        auto time_start = std::chrono::steady_clock::now();
+        auto [crit, evals] = run();
+        auto time_stop = std::chrono::steady_clock::now();
+        double time = std::chrono::duration<double>(
+            time_stop - time_start
+        ).count();
+
+        times.push_back(time);
+        crits.push_back(crit);
+        rates.push_back(evals / time);
+    }
+
+    return {
+        procs, works, threads, name, trials,
+        summarize(times), summarize(crits), summarize(rates)
+    };
+}
+
+template<class Law>
+Run anneal(
+    const Scheduling::Solution &init,
+    unsigned threads,
+    hw2::Random::result_type seed
+)
+{
+    auto algo = std::make_shared<
+        hw2::BasicAnnealing<Scheduling::Solution, Scheduling::Mutation, Law>
+    >(threads, Scheduling::Mutation(), Law(1000.), seed);
+
+    return [algo, init]() -> Outcome {
+        auto best = algo->run(init);
+        return {best->criterion(), algo->progress().evaluations};
+    };
+}
+
+Run search(
+    std::shared_ptr<hw2::LocalSearch> algo,
+    const Scheduling::Solution &init
+)
+{
+    auto sol = std::make_shared<Scheduling::Solution>(init);
+
+    return [algo, sol]() -> Outcome {
+        auto best = algo->run(sol);
+        return {best->criterion(), algo->progress().evaluations};
+    };
+}
+
+Run tabu(
+    const Scheduling::Solution &init,
+    unsigned threads,
+    hw2::Random::result_type seed
+)
+{
+    return search(
+        std::make_shared<hw2::TabuSearch>(
+            threads, std::make_shared<Scheduling::Mutation>(),
+            16u, 16u, 1000u, seed
+        ),
+        init
+    );
+}
+
+Run late_acceptance(
+    const Scheduling::Solution &init,
+    unsigned threads,
+    hw2::Random::result_type seed
+)
+{
+    return search(
+        std::make_shared<hw2::LateAcceptance>(
+            threads, std::make_shared<Scheduling::Mutation>(),
+            100u, 10000u, seed
+        ),
+        init
+    );
+}
+
+// Four levels per thread, as in `main.cc`.
+Run tempering(
+    const Scheduling::Solution &init,
+    unsigned threads,
+    hw2::Random::result_type seed
+)
+{
+    auto algo = std::make_shared<hw2::Tempering>(
+        threads, std::make_shared<Scheduling::Mutation>(),
+        hw2::Tempering::ladder(1000., 1., 4u * threads), 100u, seed
+    );
+    auto sol = std::make_shared<Scheduling::Solution>(init);
+
+    return [algo, sol]() -> Outcome {
+        auto best = algo->run(sol);
+        return {best->criterion(), algo->progress().evaluations};
+    };
+}
+
+void print_csv_header(void) {
+    std::cout << "procs,works,threads,law,trials";
+
+    for (auto key: {"time", "criterion", "rate"}) {
+        for (auto stat: {"median", "min", "max"}) {
+            std::cout << ',' << key << '_' << stat;
+        }
+    }
+
+    std::cout << '\n';
+}
+
+void print_csv(const Result &res) {
+    std::cout << res.procs << ',' << res.works << ',' << res.threads << ','
+              << res.law << ',' << res.trials;
+
+    for (const auto &sum: {res.time, res.criterion, res.rate}) {
+        std::cout << ',' << sum.median << ',' << sum.min << ',' << sum.max;
+    }
+
+    std::cout << std::endl;
+}
+
+void print_json(const Result &res, bool first) {
+    auto summary = [](const Summary &sum) {
+        return "{\"median\": " + std::to_string(sum.median)
+             + ", \"min\": " + std::to_string(sum.min)
+             + ", \"max\": " + std::to_string(sum.max) + "}";
+    };
+
+    std::cout << (first ? "[\n" : ",\n")
+              << "  {\"procs\": " << res.procs
+              << ", \"works\": " << res.works
+              << ", \"threads\": " << res.threads
+              << ", \"law\": \"" << res.law << '"'
+              << ", \"trials\": " << res.trials
+              << ", \"time\": " << summary(res.time)
+              << ", \"criterion\": " << summary(res.criterion)
+              << ", \"rate\": " << summary(res.rate) << '}' << std::flush;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 5) {
+        std::cerr << "usage: " << argv[0]
+                  << " PROCS WORKS THREADS TRIALS [csv|json [SEED]]\n"
+                  << "PROCS, WORKS and THREADS are comma-separated lists"
+                  << std::endl;
+        return 1;
+    }
+
+    auto procs_list = parse_list(argv[1]);
+    auto works_list = parse_list(argv[2]);
+    auto threads_list = parse_list(argv[3]);
+    unsigned trials = std::max(1ul, std::strtoul(argv[4], nullptr, 10));
+    bool json = argc > 5 && !std::strcmp(argv[5], "json");
+    hw2::Random::result_type seed = argc > 6
+        ? std::strtoull(argv[6], nullptr, 10)
+        : std::random_device{}();
+
+    auto print = [json, first = true](const Result &res) mutable {
+        if (json) {
+            print_json(res, first);
+        } else {
+            print_csv(res);
+        }
+        first = false;
+    };
+
+    if (!json) {
+        print_csv_header();
+    }
+
+    for (auto procs: procs_list) {
+        for (auto works: works_list) {
+            for (auto threads: threads_list) {
+                print(measure(
+                    "Boltzmann", procs, works, threads, trials, seed,
+                    anneal<hw2::BasicCD::Boltzmann>
+                ));
+                print(measure(
+                    "Cauchy", procs, works, threads, trials, seed,
+                    anneal<hw2::BasicCD::Cauchy>
+                ));
+                print(measure(
+                    "LogCauchy", procs, works, threads, trials, seed,
+                    anneal<hw2::BasicCD::LogCauchy>
+                ));
+                print(measure(
+                    "Tempering", procs, works, threads, trials, seed,
+                    tempering
+                ));
+                print(measure(
+                    "Tabu", procs, works, threads, trials, seed,
+                    tabu
+                ));
+                print(measure(
+                    "LateAcceptance", procs, works, threads, trials, seed,
+                    late_acceptance
+                ));
+            }
+        }
+    }
+
+    if (json) {
+        std::cout << "\n]" << std::endl;
+    }
+
+    return 0;
+}
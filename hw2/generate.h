@@ -0,0 +1,191 @@
+#ifndef _HW2_GENERATE_H
+#define _HW2_GENERATE_H
+
+#include "instance.h"
+#include "random.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace hw2 {
+    class DataGenerator;
+}
+
+// Work times are drawn in chunks of `chunk_size`, the chunk number
+// being mixed into the seed. The output depends only on the seed and
+// the parameters, not on the number of threads doing the work.
+class hw2::DataGenerator {
+public:
+    enum class Law {
+        Uniform,                        // Uniform on [min, max].
+        Pareto,                         // Heavy-tailed, clipped at max.
+        Bimodal                         // Short and long works in halves.
+    };
+
+private:
+    static constexpr std::size_t chunk_size = 1u << 16;
+
+    Random::result_type seed;
+    Law law;
+    unsigned n_proc;
+    unsigned n_works;
+    unsigned time_min;
+    unsigned time_max;
+
+    template<class Body>
+    static void for_each_chunk(std::size_t, Body);
+
+    unsigned draw(Random&) const;
+    void fill(std::span<unsigned>, std::size_t) const;
+    std::string format(std::span<const unsigned>) const;
+
+public:
+    DataGenerator(
+        unsigned, unsigned, unsigned, unsigned,
+        Law = Law::Uniform,
+        Random::result_type = std::random_device{}()
+    );
+
+    std::vector<unsigned> generate(void) const;
+    void generate(const std::filesystem::path&) const;
+};
+
+hw2::DataGenerator::DataGenerator(
+    unsigned procs,
+    unsigned works,
+    unsigned min,
+    unsigned max,
+    Law dist,
+    Random::result_type master
+)
+    : seed(master)
+    , law(dist)
+    , n_proc(procs)
+    , n_works(works)
+    , time_min(min)
+    , time_max(max)
+{}
+
+// Call `body(chunk, begin, end)` for every chunk of `size` items,
+// spreading the chunks over the available cores.
+template<class Body>
+void hw2::DataGenerator::for_each_chunk(std::size_t size, Body body) {
+    std::size_t n_chunks = (size + chunk_size - 1u) / chunk_size;
+    std::size_t n_threads = std::min<std::size_t>(
+        std::max(1u, std::thread::hardware_concurrency()), n_chunks
+    );
+    std::vector<std::thread> threads;
+
+    for (std::size_t id = 0u; id < n_threads; ++id) {
+        threads.emplace_back([=] {
+            for (auto chunk = id; chunk < n_chunks; chunk += n_threads) {
+                std::size_t begin = chunk * chunk_size;
+                body(chunk, begin, std::min(begin + chunk_size, size));
+            }
+        });
+    }
+
+    for (auto &thr: threads) {
+        thr.join();
+    }
+}
+
+unsigned hw2::DataGenerator::draw(Random &rng) const {
+    switch (law) {
+    case Law::Pareto: {
+        double u = std::uniform_real_distribution(0., 1.)(rng);
+        double time = time_min * std::pow(1. - u, -1. / 1.5);
+        return time < time_max ? unsigned(time) : time_max;
+    }
+    case Law::Bimodal: {
+        unsigned quarter = (time_max - time_min) / 4u;
+        if (rng() & 1u) {
+            return std::uniform_int_distribution(
+                time_min, time_min + quarter
+            )(rng);
+        }
+        return std::uniform_int_distribution(
+            time_max - quarter, time_max
+        )(rng);
+    }
+    default:
+        return std::uniform_int_distribution(time_min, time_max)(rng);
+    }
+}
+
+// The seed of a chunk is hashed from both numbers, so that instances
+// of close seeds don't share chunks.
+void hw2::DataGenerator::fill(std::span<unsigned> out, std::size_t chunk)
+const
+{
+    Random rng(Random::mix(Random::mix(seed) + chunk));
+
+    for (auto &time: out) {
+        time = draw(rng);
+    }
+}
+
+// Text of the chunk, every number preceded by a comma.
+std::string hw2::DataGenerator::format(std::span<const unsigned> times) const
+{
+    std::string ans(times.size() * 11u, '\0');
+    char *cur = ans.data();
+
+    for (auto time: times) {
+        *cur++ = ',';
+        cur = std::to_chars(cur, ans.data() + ans.size(), time).ptr;
+    }
+
+    ans.resize(cur - ans.data());
+    return ans;
+}
+
+// Work times, generated in parallel.
+std::vector<unsigned> hw2::DataGenerator::generate(void) const {
+    std::vector<unsigned> times(n_works);
+
+    for_each_chunk(times.size(), [&](auto chunk, auto begin, auto end) {
+        fill({times.data() + begin, end - begin}, chunk);
+    });
+
+    return times;
+}
+
+// Files named `*.bin` get the binary format, the others are written
+// as text, formatted in parallel and flushed one chunk at a time.
+void hw2::DataGenerator::generate(const std::filesystem::path &path) const {
+    std::vector<unsigned> times = generate();
+
+    if (path.extension() == ".bin") {
+        Scheduling::Instance(n_proc, std::move(times)).save(path);
+        return;
+    }
+
+    std::vector<std::string> texts(
+        (times.size() + chunk_size - 1u) / chunk_size
+    );
+
+    for_each_chunk(times.size(), [&](auto chunk, auto begin, auto end) {
+        texts[chunk] = format({times.data() + begin, end - begin});
+    });
+
+    std::ofstream file(path, std::ios::binary);
+    file << n_proc;
+
+    for (const auto &text: texts) {
+        file.write(text.data(), text.size());
+    }
+
+    file << '\n';
+    file.close();
+}
+
+#endif // _HW2_GENERATE_H
@@ -0,0 +1,198 @@
+#ifndef _HW2_INSTANCE_H
+#define _HW2_INSTANCE_H
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Scheduling {
+    class Instance;
+
+    struct BinaryHeader;
+
+    using InstancePtr = std::shared_ptr<const Instance>;
+}
+
+// Layout of a binary instance file: this header, then `n_works`
+// work times as native-endian 32-bit integers.
+struct Scheduling::BinaryHeader {
+    static constexpr char signature[4] = {'H', 'W', '2', 'S'};
+
+    char magic[4];
+    std::uint32_t n_proc;
+    std::uint64_t n_works;
+};
+
+static_assert(sizeof(unsigned) == sizeof(std::uint32_t));
+
+// Number of processors and work times of a scheduling problem.
+// Either format is read through a memory mapping: text is parsed
+// into a buffer sized in advance, while binary work times are used
+// right from the mapping, without copying.
+class Scheduling::Instance {
+    unsigned n_proc;
+    std::vector<unsigned> buffer;
+    std::span<const unsigned> work_times;
+    void *mapping;
+    std::size_t mapping_size;
+
+    void parse_text(const char*, const char*);
+
+public:
+    Instance(unsigned, std::vector<unsigned>);
+    Instance(const std::filesystem::path&);
+    Instance(const Instance&) = delete;
+    Instance &operator=(const Instance&) = delete;
+    ~Instance();
+
+    unsigned procs(void) const { return n_proc; }
+    std::span<const unsigned> times(void) const { return work_times; }
+
+    void save(const std::filesystem::path&) const;
+};
+
+Scheduling::Instance::Instance(unsigned procs, std::vector<unsigned> times)
+    : n_proc(procs)
+    , buffer(std::move(times))
+    , work_times(buffer)
+    , mapping(nullptr)
+    , mapping_size(0u)
+{}
+
+// Binary files are told from text ones by their signature.
+Scheduling::Instance::Instance(const std::filesystem::path &path)
+    : n_proc(0u)
+    , mapping(nullptr)
+    , mapping_size(0u)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+
+    if (fd < 0) {
+        throw std::invalid_argument("can't open file");
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        close(fd);
+        throw std::invalid_argument("can't read file");
+    }
+
+    mapping_size = st.st_size;
+    mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        throw std::invalid_argument("can't map file");
+    }
+
+    const char *begin = static_cast<const char*>(mapping);
+    BinaryHeader header;
+
+    if (
+        mapping_size >= sizeof(header)
+        && !std::memcmp(begin, BinaryHeader::signature, sizeof(header.magic))
+    ) {
+        std::memcpy(&header, begin, sizeof(header));
+
+        if (
+            header.n_works
+            > (mapping_size - sizeof(header)) / sizeof(std::uint32_t)
+        ) {
+            munmap(mapping, mapping_size);
+            throw std::invalid_argument("truncated instance file");
+        }
+
+        n_proc = header.n_proc;
+        work_times = {
+            reinterpret_cast<const unsigned*>(begin + sizeof(header)),
+            header.n_works
+        };
+        return;
+    }
+
+    try {
+        parse_text(begin, begin + mapping_size);
+    } catch (...) {
+        munmap(mapping, mapping_size);
+        throw;
+    }
+
+    munmap(mapping, mapping_size);
+    mapping = nullptr;
+}
+
+Scheduling::Instance::~Instance() {
+    if (mapping) {
+        munmap(mapping, mapping_size);
+    }
+}
+
+// Text format: `N_PROC,T_1,T_2,...,T_N`. The numbers may be separated by
+// any run of commas and whitespace, e.g. one per line.
+void Scheduling::Instance::parse_text(const char *cur, const char *end) {
+    auto space = [](char c) { return std::isspace((unsigned char)c); };
+    auto separator = [&space](char c) { return c == ',' || space(c); };
+
+    buffer.reserve(
+        std::count_if(cur, end, [](char c) { return c == ',' || c == '\n'; })
+    );
+
+    cur = std::find_if_not(cur, end, space);
+    auto res = std::from_chars(cur, end, n_proc);
+
+    if (res.ec != std::errc()) {
+        throw std::invalid_argument("bad instance file");
+    }
+
+    cur = std::find_if_not(res.ptr, end, space);
+
+    while (cur != end) {
+        unsigned time;
+        res = std::from_chars(std::find_if_not(cur, end, separator), end, time);
+
+        if (res.ec != std::errc()) {
+            throw std::invalid_argument("bad instance file");
+        }
+
+        buffer.push_back(time);
+        cur = std::find_if_not(res.ptr, end, space);
+    }
+
+    work_times = buffer;
+}
+
+// Write the instance in the binary format.
+void Scheduling::Instance::save(const std::filesystem::path &path) const {
+    std::ofstream file(path, std::ios::binary);
+
+    if (!file.is_open()) {
+        throw std::invalid_argument("can't open file");
+    }
+
+    BinaryHeader header = {{}, n_proc, work_times.size()};
+    std::memcpy(header.magic, BinaryHeader::signature, sizeof(header.magic));
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(
+        reinterpret_cast<const char*>(work_times.data()),
+        work_times.size_bytes()
+    );
+    file.close();
+}
+
+#endif // _HW2_INSTANCE_H
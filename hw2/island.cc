@@ -0,0 +1,91 @@
+#include "island.h"
+#include "scheduling.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using Island = hw2::Island<
+    Scheduling::Solution, Scheduling::Mutation, hw2::BasicCD::Cauchy
+>;
+
+// One island per process, spread over the NUMA nodes round-robin.
+// Every process loads the instance and builds its solutions itself,
+// after it is pinned, so its memory is local to its node.
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        std::cerr << "usage: " << argv[0]
+                  << " N_PROC INPUT_PATH N_ISLANDS [SEED]" << std::endl;
+        return 1;
+    }
+
+    unsigned n_proc = std::strtoul(argv[1], nullptr, 10);
+    unsigned n_islands = std::strtoul(argv[3], nullptr, 10);
+    hw2::Random::result_type seed = argc > 4
+        ? std::strtoull(argv[4], nullptr, 10)
+        : std::random_device{}();
+
+    auto nodes = hw2::numa_nodes();
+    hw2::Random rng(seed);
+    Scheduling::Solution init(argv[2], rng, Scheduling::Start::LPT);
+
+    std::ostringstream out;
+    init.write(out);
+    hw2::Exchange exchange(
+        "/hw2-island-" + std::to_string(getpid()), out.str().size()
+    );
+    exchange.offer(init);
+
+    auto time_start = std::chrono::high_resolution_clock::now();
+
+    for (unsigned id = 0u; id < n_islands; ++id) {
+        pid_t pid = fork();
+
+        if (pid < 0) {
+            std::cerr << "can't fork" << std::endl;
+            return 1;
+        }
+
+        if (pid == 0) {
+            const auto &cpus = nodes[id % nodes.size()];
+            hw2::pin(cpus);
+
+            hw2::Random seeds(hw2::Random::mix(seed) + id);
+            Island island(
+                n_proc, {}, hw2::BasicCD::Cauchy(1000.), cpus, exchange,
+                seeds()
+            );
+
+            hw2::Random local(seeds());
+            Scheduling::Solution sol(
+                argv[2], local, Scheduling::Start::RandomGreedy
+            );
+            island.run(
+                sol,
+                std::make_shared<hw2::BasicStop::Stall>(10u),
+                std::make_shared<hw2::BasicStop::Stall>(5u)
+            );
+            return 0;
+        }
+    }
+
+    for (unsigned id = 0u; id < n_islands; ++id) {
+        wait(nullptr);
+    }
+
+    auto time_stop = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> time = time_stop - time_start;
+    std::uint64_t version = 0u;
+    exchange.fetch(init, version);
+
+    std::cout << "islands = " << n_islands << ' '
+              << "nodes = " << nodes.size() << ' '
+              << "criterion = " << init.criterion() << ' '
+              << "time = " << time.count() << std::endl;
+    return 0;
+}
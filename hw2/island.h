@@ -0,0 +1,420 @@
+#ifndef _HW2_ISLAND_H
+#define _HW2_ISLAND_H
+
+#include "annealing.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace hw2 {
+    template<class S, class M, class C>
+    class Island;
+
+    class Exchange;
+
+    std::vector<std::vector<unsigned>> numa_nodes(void);
+    bool pin(const std::vector<unsigned>&);
+} // namespace hw2
+
+// CPUs of every NUMA node, as listed in sysfs.
+// Without NUMA support the whole machine is one node.
+std::vector<std::vector<unsigned>> hw2::numa_nodes(void) {
+    std::vector<std::vector<unsigned>> ans;
+    std::filesystem::path root = "/sys/devices/system/node";
+
+    for (unsigned node = 0u; ; ++node) {
+        std::ifstream file(
+            root / ("node" + std::to_string(node)) / "cpulist"
+        );
+
+        if (!file.is_open()) {
+            break;
+        }
+
+        // Format: `0-3,8-11`.
+        std::vector<unsigned> cpus;
+        unsigned first, last;
+        char sep;
+
+        while (file >> first) {
+            last = first;
+
+            if (file.peek() == '-') {
+                file >> sep >> last;
+            }
+
+            for (unsigned cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+
+            if (file.peek() == ',') {
+                file >> sep;
+            }
+        }
+
+        if (!cpus.empty()) {
+            ans.push_back(std::move(cpus));
+        }
+    }
+
+    if (ans.empty()) {
+        ans.emplace_back(std::max(1u, std::thread::hardware_concurrency()));
+        std::iota(ans.back().begin(), ans.back().end(), 0u);
+    }
+
+    return ans;
+}
+
+// Restrict the calling thread, and the threads it creates from now on,
+// to `cpus`.
+bool hw2::pin(const std::vector<unsigned> &cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+
+    for (auto cpu: cpus) {
+        CPU_SET(cpu, &set);
+    }
+
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+// Best solution of a group of islands, in a POSIX shared-memory segment.
+// The segment holds a process-shared, robust mutex, the criterion and
+// version of the solution, and two slots for its binary form as written
+// by `write`. A new best goes to the inactive slot, which is only made
+// active once complete, so an island that dies while holding the mutex
+// neither blocks the others nor leaves a torn solution behind.
+//
+// The creator unlinks the segment when it is destroyed. Children
+// forked after its creation share the mapping.
+class hw2::Exchange {
+    struct Header {
+        pthread_mutex_t lock;
+        std::uint64_t version;          // Bumped on every new best.
+        std::uint32_t active;           // Slot holding the solution.
+        double criterion[2];            // Of the solution in each slot.
+        std::uint64_t size[2];          // Of the data in each slot.
+    };
+
+    std::string name;
+    pid_t creator;
+    void *mapping;
+    std::size_t mapping_size;
+    std::size_t capacity;               // Of a slot.
+    Header *header;
+    char *data;                         // Both slots.
+
+    void map(int, std::size_t);
+    void lock(void);
+    void unlock(void);
+
+public:
+    Exchange(const std::string&, std::size_t);
+    Exchange(const std::string&);
+    Exchange(const Exchange&) = delete;
+    Exchange &operator=(const Exchange&) = delete;
+    ~Exchange();
+
+    template<class S>
+    bool offer(const S&);
+    template<class S>
+    bool fetch(S&, std::uint64_t&);
+
+    double criterion(void);
+};
+
+// Create the segment `name` with room for `size` bytes of solution.
+hw2::Exchange::Exchange(const std::string &shm_name, std::size_t size)
+    : name(shm_name)
+    , creator(getpid())
+    , mapping(nullptr)
+    , mapping_size(sizeof(Header) + 2u * size)
+    , capacity(size)
+{
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+
+    if (fd < 0) {
+        throw std::invalid_argument("can't create shared memory");
+    }
+
+    if (ftruncate(fd, mapping_size) < 0) {
+        close(fd);
+        shm_unlink(name.c_str());
+        throw std::invalid_argument("can't size shared memory");
+    }
+
+    map(fd, mapping_size);
+
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&header->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    header->version = 0u;
+    header->active = 0u;
+
+    for (unsigned slot = 0u; slot < 2u; ++slot) {
+        header->criterion[slot] = std::numeric_limits<double>::infinity();
+        header->size[slot] = 0u;
+    }
+}
+
+// Attach to the existing segment `name`.
+hw2::Exchange::Exchange(const std::string &shm_name)
+    : name(shm_name)
+    , creator(0)
+    , mapping(nullptr)
+    , mapping_size(0u)
+    , capacity(0u)
+{
+    int fd = shm_open(name.c_str(), O_RDWR, 0600);
+
+    if (fd < 0) {
+        throw std::invalid_argument("can't open shared memory");
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) < 0 || std::size_t(st.st_size) < sizeof(Header)) {
+        close(fd);
+        throw std::invalid_argument("bad shared memory");
+    }
+
+    map(fd, st.st_size);
+    capacity = (mapping_size - sizeof(Header)) / 2u;
+}
+
+hw2::Exchange::~Exchange() {
+    munmap(mapping, mapping_size);
+
+    if (creator == getpid()) {
+        shm_unlink(name.c_str());
+    }
+}
+
+// Map the segment behind `fd` and close it.
+void hw2::Exchange::map(int fd, std::size_t size) {
+    mapping_size = size;
+    mapping = mmap(
+        nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0
+    );
+    close(fd);
+
+    if (mapping == MAP_FAILED) {
+        if (creator) {
+            shm_unlink(name.c_str());
+        }
+        throw std::invalid_argument("can't map shared memory");
+    }
+
+    header = static_cast<Header*>(mapping);
+    data = static_cast<char*>(mapping) + sizeof(Header);
+}
+
+// If the previous owner died, the active slot is still intact.
+void hw2::Exchange::lock(void) {
+    if (pthread_mutex_lock(&header->lock) == EOWNERDEAD) {
+        pthread_mutex_consistent(&header->lock);
+    }
+}
+
+void hw2::Exchange::unlock(void) {
+    pthread_mutex_unlock(&header->lock);
+}
+
+double hw2::Exchange::criterion(void) {
+    lock();
+    double ans = header->criterion[header->active];
+    unlock();
+    return ans;
+}
+
+// Make `sol` the shared best if it beats the current one.
+template<class S>
+bool hw2::Exchange::offer(const S &sol) {
+    double crit = sol.criterion();
+
+    // Cheap check first, serialize only for a likely winner.
+    if (crit >= criterion()) {
+        return false;
+    }
+
+    std::ostringstream out;
+    sol.write(out);
+    std::string bytes = std::move(out).str();
+
+    if (bytes.size() > capacity) {
+        throw std::invalid_argument("solution too large for shared memory");
+    }
+
+    lock();
+
+    bool ans = crit < header->criterion[header->active];
+
+    if (ans) {
+        std::uint32_t slot = 1u - header->active;
+        std::memcpy(data + slot * capacity, bytes.data(), bytes.size());
+        header->size[slot] = bytes.size();
+        header->criterion[slot] = crit;
+        header->active = slot;
+        ++header->version;
+    }
+
+    unlock();
+    return ans;
+}
+
+// Replace `sol` with the shared best if that is newer than `version`
+// and better than `sol`, update `version`.
+template<class S>
+bool hw2::Exchange::fetch(S &sol, std::uint64_t &version) {
+    std::string bytes;
+
+    lock();
+
+    std::uint32_t slot = header->active;
+    bool ans = header->version != version
+            && header->criterion[slot] < sol.criterion();
+
+    if (ans) {
+        bytes.assign(data + slot * capacity, header->size[slot]);
+        version = header->version;
+    }
+
+    unlock();
+
+    if (ans) {
+        std::istringstream in(std::move(bytes));
+        sol.read(in);
+    }
+
+    return ans;
+}
+
+// An annealing engine whose workers are pinned to a set of CPUs, e.g.
+// a NUMA node, cooperating with other islands through an `Exchange`.
+// Workers inherit the affinity of the thread that creates them, and
+// allocate their memory once pinned, so by the first-touch policy it
+// is local to their node.
+//
+// An island anneals in epochs. After each one it offers its best to
+// the exchange and continues from the shared best if that is better.
+// Islands may be threads of the same process, or separate processes
+// sharing the exchange. Only what the engine allocates is node-local:
+// data the solutions share, e.g. the instance of a scheduling solution,
+// stays where it was allocated. Separate processes that each load it
+// once pinned, as `island.cc` does, keep it local too, and then nothing
+// but the best solutions crosses a node boundary.
+template<class S, class M, class C>
+class hw2::Island {
+public:
+    using Engine = BasicAnnealing<S, M, C>;
+    using Snapshot = typename Engine::Snapshot;
+
+private:
+    std::unique_ptr<Engine> engine;
+    Exchange &exchange;
+
+public:
+    Island(
+        unsigned, M, C, const std::vector<unsigned>&, Exchange&,
+        Random::result_type = std::random_device{}()
+    );
+
+    Snapshot run(S, StoppingPtr, StoppingPtr);
+    Engine &get_engine(void) { return *engine; }
+};
+
+// `n_proc` workers on `cpus`, the calling thread keeps its affinity.
+template<class S, class M, class C>
+hw2::Island<S, M, C>::Island(
+    unsigned n_proc,
+    M mut,
+    C cd,
+    const std::vector<unsigned> &cpus,
+    Exchange &shared,
+    Random::result_type seed
+)
+    : exchange(shared)
+{
+    cpu_set_t old_set;
+    bool pinned = sched_getaffinity(0, sizeof(old_set), &old_set) == 0
+               && pin(cpus);
+
+    engine = std::make_unique<Engine>(
+        n_proc, std::move(mut), std::move(cd), seed
+    );
+
+    if (pinned) {
+        sched_setaffinity(0, sizeof(old_set), &old_set);
+    }
+}
+
+// Epochs are stopped by `epoch`, the whole run by `total`, which sees
+// the evaluations of this island, the best criterion it knows of,
+// and epochs without a new one.
+template<class S, class M, class C>
+hw2::Island<S, M, C>::Snapshot hw2::Island<S, M, C>::run(
+    S init,
+    StoppingPtr epoch,
+    StoppingPtr total
+)
+{
+    Snapshot best = std::make_shared<const S>(std::move(init));
+    Progress prog = {0ul, best->criterion(), 0u, {}};
+    std::uint64_t version = 0u;
+    auto start = Clock::now();
+
+    while (!total->done(prog)) {
+        Snapshot cur = engine->run(*best, epoch);
+        prog.evaluations += engine->progress().evaluations;
+
+        exchange.offer(*cur);
+
+        S next = *cur;
+
+        if (exchange.fetch(next, version)) {
+            cur = std::make_shared<const S>(std::move(next));
+        }
+
+        if (cur->criterion() < prog.criterion) {
+            prog.criterion = cur->criterion();
+            prog.not_improved = 0u;
+        } else {
+            ++prog.not_improved;
+        }
+
+        best = cur;
+        prog.elapsed = Clock::now() - start;
+
+        if (engine->gap() <= 0.) {
+            break;
+        }
+    }
+
+    return best;
+}
+
+#endif // _HW2_ISLAND_H
@@ -0,0 +1,322 @@
+#ifndef _HW2_LOCAL_H
+#define _HW2_LOCAL_H
+
+#include "annealing.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace hw2 {
+    class LocalSearch;
+    class TabuSearch;
+    class LateAcceptance;
+} // namespace hw2
+
+// Parallel driver of the local searches below, over the polymorphic
+// interfaces. Works like a synchronous `Annealing` run, on the same
+// `Workers` and `Budget`: every round each worker searches from the
+// best solution so far with its own clone of the mutation, and the
+// coordinator keeps the best of their results.
+//
+// A search implements `payload`, called by worker `id` with the
+// solution to start from, and may keep state of its own per worker,
+// e.g. a memory, which `reset` clears at the start of every run.
+// It calls `charge` and `reached` as `Budget` says, and returns as soon
+// as either says so.
+class hw2::LocalSearch: public hw2::Budget {
+    std::vector<SolutionPtr> locals;    // Where each worker starts from,
+                                        // then what it ended with.
+    std::vector<MutationPtr> muts;      // One per worker and run.
+    SolutionPtr best;
+    MutationPtr mutation;
+    Workers crew;                       // Last, to stop before the rest.
+
+protected:
+    virtual SolutionPtr payload(unsigned, SolutionPtr, Mutation&, Random&)
+        = 0;
+    virtual void reset(void) {}
+
+public:
+    LocalSearch(
+        unsigned, MutationPtr, Random::result_type = std::random_device{}()
+    );
+    LocalSearch(const LocalSearch&) = delete;
+    LocalSearch &operator=(const LocalSearch&) = delete;
+    virtual ~LocalSearch() = default;
+
+    SolutionPtr run(SolutionPtr);
+    SolutionPtr run(SolutionPtr, StoppingPtr);
+};
+
+// Tabu search: every step samples `sample` moves, and applies the best
+// of those that aren't tabu, even if it makes the solution worse.
+// A tabu move is still taken if it beats the best solution of the
+// search. Applying a move makes its reversal tabu for `tenure` steps.
+//
+// The memory is hashed on `Solution::undo_key` and `move_key` into
+// a table of expiry steps: colliding keys share an entry, which only
+// makes some moves tabu a little longer, and a lookup costs the same
+// whatever the tenure. Moves are sampled with `propose` and undone, the
+// chosen one is replayed from a copy of the generator, so `propose`
+// must depend only on the solution, the mutation and the generator.
+// The mutation hears only about the moves that are applied.
+class hw2::TabuSearch final: public hw2::LocalSearch {
+    static constexpr unsigned memory_size = 4096u;  // A power of two.
+
+    struct Memory {
+        std::vector<unsigned long> expiry;
+        unsigned long step;
+    };
+
+    unsigned sample;
+    unsigned tenure;
+    unsigned steps;                     // Per round.
+    std::vector<Memory> memories;       // One per worker.
+
+protected:
+    SolutionPtr payload(unsigned, SolutionPtr, Mutation&, Random&) override;
+    void reset(void) override;
+
+public:
+    TabuSearch(
+        unsigned, MutationPtr, unsigned = 16u, unsigned = 16u,
+        unsigned = 1000u, Random::result_type = std::random_device{}()
+    );
+};
+
+// Late acceptance hill climbing: a move is accepted if it is no worse
+// than the current solution, or than the one `length` steps ago.
+// The history makes it climb out of the local minima the plain hill
+// climber gets stuck in, without a temperature to tune.
+class hw2::LateAcceptance final: public hw2::LocalSearch {
+    unsigned length;                    // Of the history.
+    unsigned steps;                     // Per round.
+
+protected:
+    SolutionPtr payload(unsigned, SolutionPtr, Mutation&, Random&) override;
+
+public:
+    LateAcceptance(
+        unsigned, MutationPtr, unsigned = 100u, unsigned = 10000u,
+        Random::result_type = std::random_device{}()
+    );
+};
+
+// Worker generators are seeded from `seed`. Workers only call `payload`
+// once a run has started, after the derived class is constructed.
+hw2::LocalSearch::LocalSearch(
+    unsigned n_proc,
+    MutationPtr mut,
+    Random::result_type seed
+)
+    : locals(n_proc)
+    , muts(n_proc)
+    , best(nullptr)
+    , mutation(mut)
+    , crew(
+        n_proc,
+        [this](unsigned id, Random &rng) {
+            locals[id] = payload(id, locals[id], *muts[id], rng);
+        },
+        seed
+    )
+{}
+
+// Stops after 10 rounds in a row without a new best.
+hw2::SolutionPtr hw2::LocalSearch::run(SolutionPtr init) {
+    return run(init, std::make_shared<BasicStop::Stall>(10u));
+}
+
+hw2::SolutionPtr hw2::LocalSearch::run(SolutionPtr init, StoppingPtr policy) {
+    best = init;
+    std::fill(locals.begin(), locals.end(), best);
+
+    for (auto &mut: muts) {
+        mut = mutation->clone();
+    }
+
+    begin(policy, best->criterion(), best->lower_bound());
+    reset();
+    best = drive(crew, locals, best, [](bool, SolutionPtr) {});
+
+    std::fill(locals.begin(), locals.end(), nullptr);
+    return best;
+}
+
+hw2::TabuSearch::TabuSearch(
+    unsigned n_proc,
+    MutationPtr mut,
+    unsigned moves,
+    unsigned tabu_tenure,
+    unsigned round_steps,
+    Random::result_type seed
+)
+    : LocalSearch(n_proc, mut, seed)
+    , sample(std::max(1u, moves))
+    , tenure(tabu_tenure)
+    , steps(round_steps)
+    , memories(n_proc)
+{}
+
+void hw2::TabuSearch::reset(void) {
+    for (auto &mem: memories) {
+        mem.expiry.assign(memory_size, 0ul);
+        mem.step = 0ul;
+    }
+}
+
+// Run `steps` steps from `init`, return the best solution seen.
+// The memory carries over from round to round.
+hw2::SolutionPtr hw2::TabuSearch::payload(
+    unsigned id,
+    SolutionPtr init,
+    Mutation &mut,
+    Random &rng
+)
+{
+    Memory &mem = memories[id];
+    const std::uint64_t mask = memory_size - 1u;
+
+    SolutionPtr sol_best = init;
+    double crit_best = init->criterion();
+
+    SolutionPtr sol_cur = init->clone();
+    double crit_cur = crit_best;
+
+    unsigned pending = 0u;              // Not yet charged.
+
+    for (unsigned step = 0u; step < steps; ++step, ++mem.step) {
+        if (pending >= check_period) {
+            bool done = charge(pending);
+            pending = 0u;
+
+            if (done) {
+                break;
+            }
+        }
+
+        Random chosen = rng;
+        double crit_chosen = std::numeric_limits<double>::infinity();
+
+        for (unsigned i = 0u; i < sample; ++i) {
+            Random before = rng;
+            mut.propose(*sol_cur, rng);
+            double crit_new = sol_cur->criterion();
+            std::uint64_t key = sol_cur->move_key();
+            sol_cur->undo();
+            ++pending;
+
+            bool tabu = key && mem.expiry[key & mask] > mem.step;
+
+            if ((!tabu || crit_new < crit_best) && crit_new < crit_chosen) {
+                chosen = before;
+                crit_chosen = crit_new;
+            }
+        }
+
+        if (crit_chosen == std::numeric_limits<double>::infinity()) {
+            continue;
+        }
+
+        mut.propose(*sol_cur, chosen);
+        std::uint64_t key = sol_cur->undo_key();
+
+        if (key) {
+            mem.expiry[key & mask] = mem.step + tenure + 1u;
+        }
+
+        sol_cur->commit();
+        mut.feedback(true, crit_cur - crit_chosen);
+        crit_cur = crit_chosen;
+
+        if (crit_cur < crit_best) {
+            sol_best = sol_cur->clone();
+            crit_best = crit_cur;
+
+            if (reached(crit_best)) {
+                break;
+            }
+        }
+    }
+
+    charge(pending);
+    return sol_best;
+}
+
+hw2::LateAcceptance::LateAcceptance(
+    unsigned n_proc,
+    MutationPtr mut,
+    unsigned history,
+    unsigned round_steps,
+    Random::result_type seed
+)
+    : LocalSearch(n_proc, mut, seed)
+    , length(std::max(1u, history))
+    , steps(round_steps)
+{}
+
+// Run `steps` steps from `init`, return the best solution seen.
+// The history starts afresh every round, filled with `init`.
+hw2::SolutionPtr hw2::LateAcceptance::payload(
+    unsigned,
+    SolutionPtr init,
+    Mutation &mut,
+    Random &rng
+)
+{
+    SolutionPtr sol_best = init;
+    double crit_best = init->criterion();
+
+    SolutionPtr sol_cur = init->clone();
+    double crit_cur = crit_best;
+
+    std::vector<double> history(length, crit_cur);
+    unsigned pending = 0u;              // Not yet charged.
+
+    for (unsigned step = 0u; step < steps; ++step) {
+        if (pending == check_period) {
+            bool done = charge(pending);
+            pending = 0u;
+
+            if (done) {
+                break;
+            }
+        }
+
+        mut.propose(*sol_cur, rng);
+        double crit_new = sol_cur->criterion();
+        ++pending;
+
+        double &late = history[step % length];
+        double _diff = crit_cur - crit_new;
+        bool accepted = _diff >= 0. || crit_new <= late;
+
+        if (accepted) {
+            sol_cur->commit();
+            crit_cur = crit_new;
+        } else {
+            sol_cur->undo();
+        }
+
+        mut.feedback(accepted, _diff);
+        late = crit_cur;
+
+        if (crit_cur < crit_best) {
+            sol_best = sol_cur->clone();
+            crit_best = crit_cur;
+
+            if (reached(crit_best)) {
+                break;
+            }
+        }
+    }
+
+    charge(pending);
+    return sol_best;
+}
+
+#endif // _HW2_LOCAL_H
@@ -1,7 +1,15 @@
+#include "local.h"
 #include "scheduling.h"
+#include "tempering.h"
 
 #include <chrono>
 #include <iostream>
+#include <random>
+
+template<class Law>
+using Engine = hw2::BasicAnnealing<
+    Scheduling::Solution, Scheduling::Mutation, Law
+>;
 
 void print_sched(const std::vector<std::vector<unsigned>> &vec) {
     for (unsigned proc = 0; proc < vec.size(); ++proc) {
@@ -15,24 +23,28 @@ void print_sched(const std::vector<std::vector<unsigned>> &vec) {
 
 int main(int argc, char *argv[]) {
     if (argc < 3) {
-        std::cerr << "usage: " << argv[0] << " N_PROC INPUT_PATH" << std::endl;
+        std::cerr << "usage: " << argv[0]
+                  << " N_PROC INPUT_PATH [SEED]" << std::endl;
         return 1;
     }
 
     unsigned n_proc = std::strtoul(argv[1], nullptr, 10);
+    hw2::Random::result_type seed = argc > 3
+        ? std::strtoull(argv[3], nullptr, 10)
+        : std::random_device{}();
+    hw2::Random rng(seed);
+
     auto mutation = std::make_shared<Scheduling::Mutation>();
-    auto sol = std::make_shared<Scheduling::Solution>(argv[2]);
+    Scheduling::Solution sol(argv[2], rng);
     std::chrono::duration<double> time;
 
     std::cout << "Boltzmann law: ";
-    hw2::Annealing algo_boltzmann(
-        n_proc, mutation, std::make_shared<hw2::BasicCD::Boltzmann>(1000.)
+    Engine<hw2::BasicCD::Boltzmann> algo_boltzmann(
+        n_proc, {}, hw2::BasicCD::Boltzmann(1000.), seed
     );
 
     auto time_start = std::chrono::high_resolution_clock::now();
-    auto best = std::dynamic_pointer_cast<Scheduling::Solution>(
-        algo_boltzmann.run(sol)
-    );
+    auto best = algo_boltzmann.run(sol);
     auto time_stop = std::chrono::high_resolution_clock::now();
     time = time_stop - time_start;
 
@@ -40,13 +52,40 @@ int main(int argc, char *argv[]) {
     std::cout << "time = " << time.count() << std::endl;
 
     std::cout << "Cauchy law: ";
-    hw2::Annealing algo_cauchy(
-        n_proc, mutation, std::make_shared<hw2::BasicCD::Cauchy>(1000.)
+    Engine<hw2::BasicCD::Cauchy> algo_cauchy(
+        n_proc, {}, hw2::BasicCD::Cauchy(1000.), seed
+    );
+
+    time_start = std::chrono::high_resolution_clock::now();
+    best = algo_cauchy.run(sol);
+    time_stop = std::chrono::high_resolution_clock::now();
+    time = time_stop - time_start;
+
+    std::cout << "criterion = " << best->criterion() << ' ';
+    std::cout << "time = " << time.count() << std::endl;
+
+    std::cout << "Log Cauchy law: ";
+    Engine<hw2::BasicCD::LogCauchy> algo_logcauchy(
+        n_proc, {}, hw2::BasicCD::LogCauchy(1000.), seed
+    );
+
+    time_start = std::chrono::high_resolution_clock::now();
+    best = algo_logcauchy.run(sol);
+    time_stop = std::chrono::high_resolution_clock::now();
+    time = time_stop - time_start;
+
+    std::cout << "criterion = " << best->criterion() << ' ';
+    std::cout << "time = " << time.count() << std::endl;
+
+    std::cout << "Parallel tempering: ";
+    hw2::Tempering algo_tempering(
+        n_proc, mutation, hw2::Tempering::ladder(1000., 1., 4u * n_proc),
+        100u, seed
     );
 
     time_start = std::chrono::high_resolution_clock::now();
     best = std::dynamic_pointer_cast<Scheduling::Solution>(
-        algo_cauchy.run(sol)
+        algo_tempering.run(std::make_shared<Scheduling::Solution>(sol))
     );
     time_stop = std::chrono::high_resolution_clock::now();
     time = time_stop - time_start;
@@ -54,14 +93,25 @@ int main(int argc, char *argv[]) {
     std::cout << "criterion = " << best->criterion() << ' ';
     std::cout << "time = " << time.count() << std::endl;
 
-    std::cout << "Log Cauchy law: ";
-    hw2::Annealing algo_logcauchy(
-        n_proc, mutation, std::make_shared<hw2::BasicCD::LogCauchy>(1000.)
+    std::cout << "Tabu search: ";
+    hw2::TabuSearch algo_tabu(n_proc, mutation, 16u, 16u, 1000u, seed);
+
+    time_start = std::chrono::high_resolution_clock::now();
+    best = std::dynamic_pointer_cast<Scheduling::Solution>(
+        algo_tabu.run(std::make_shared<Scheduling::Solution>(sol))
     );
+    time_stop = std::chrono::high_resolution_clock::now();
+    time = time_stop - time_start;
+
+    std::cout << "criterion = " << best->criterion() << ' ';
+    std::cout << "time = " << time.count() << std::endl;
+
+    std::cout << "Late acceptance: ";
+    hw2::LateAcceptance algo_lahc(n_proc, mutation, 100u, 10000u, seed);
 
     time_start = std::chrono::high_resolution_clock::now();
     best = std::dynamic_pointer_cast<Scheduling::Solution>(
-        algo_logcauchy.run(sol)
+        algo_lahc.run(std::make_shared<Scheduling::Solution>(sol))
     );
     time_stop = std::chrono::high_resolution_clock::now();
     time = time_stop - time_start;
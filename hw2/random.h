@@ -0,0 +1,67 @@
+#ifndef _HW2_RANDOM_H
+#define _HW2_RANDOM_H
+
+#include <cstdint>
+#include <limits>
+
+namespace hw2 {
+    class Random;
+} // namespace hw2
+
+// xoshiro256** generator: a few cycles per number and 32 bytes of state,
+// meant to be owned by a single thread.
+// Satisfies UniformRandomBitGenerator, so it works with <random>.
+class hw2::Random {
+public:
+    using result_type = std::uint64_t;
+
+private:
+    result_type state[4];
+
+    static result_type rotl(result_type x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+public:
+    Random(result_type);
+
+    static constexpr result_type min(void) { return 0u; }
+    static constexpr result_type max(void) {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    result_type operator()(void);
+
+    static result_type mix(result_type);
+};
+
+// Expand the seed with splitmix64, as recommended by the xoshiro authors.
+hw2::Random::Random(result_type seed) {
+    for (auto &word: state) {
+        word = mix(seed += 0x9e3779b97f4a7c15u);
+    }
+}
+
+hw2::Random::result_type hw2::Random::operator()(void) {
+    result_type ans = rotl(state[1] * 5u, 7) * 9u;
+    result_type tmp = state[1] << 17;
+
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= tmp;
+    state[3] = rotl(state[3], 45);
+
+    return ans;
+}
+
+// The splitmix64 finalizer: close values give unrelated results, which
+// makes it fit to derive seeds from one another.
+hw2::Random::result_type hw2::Random::mix(result_type z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9u;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebu;
+    return z ^ (z >> 31);
+}
+
+#endif // _HW2_RANDOM_H
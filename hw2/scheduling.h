@@ -2,134 +2,472 @@
 #define _HW2_SCHEDULING_H
 
 #include "annealing.h"
+#include "instance.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <filesystem>
-#include <fstream>
+#include <functional>
+#include <istream>
 #include <limits>
+#include <numeric>
+#include <ostream>
+#include <queue>
+#include <span>
+#include <stdexcept>
 #include <vector>
 
 namespace Scheduling {
     class Solution;
     class Mutation;
 
+    enum class Start;
+    enum class Move;
+
     using SolutionPtr = std::shared_ptr<Solution>;
     using MutationPtr = std::shared_ptr<Mutation>;
 }
 
-class Scheduling::Solution: public hw2::Solution {
+// How a new solution distributes the works.
+enum class Scheduling::Start {
+    Single,                             // All on one random processor.
+    RoundRobin,                         // Work `i` on processor `i % M`.
+    LPT,                                // Longest first, to the least
+                                        // loaded processor.
+    RandomGreedy                        // Random order, to the least
+                                        // loaded processor.
+};
+
+// Neighbourhoods of `Scheduling::Mutation`.
+enum class Scheduling::Move {
+    Shift,                              // A work to another processor.
+    Swap,                               // Two works between processors.
+    Balance,                            // A work from the most loaded
+                                        // to the least loaded processor.
+    Chain                               // Ejection chain: a work moves,
+                                        // one from its new processor
+                                        // moves on, and so on.
+};
+
+class Scheduling::Solution final: public hw2::Solution {
     friend class Mutation;
 
-    std::vector<std::vector<bool>> schedule;
-    std::vector<unsigned> times;
+    InstancePtr instance;               // Shared by all the copies.
+    std::span<const unsigned> times;    // Points into `instance`.
+    std::vector<unsigned> procs;        // Processor of each work.
+
+    // Cached per-processor state, kept in sync with `procs`.
+    std::vector<unsigned long> loads;   // Total time of the works.
+    std::vector<unsigned> longest;      // Time of the longest work.
+
+    // The proposed moves, kept until they are committed or undone.
+    struct Step {
+        unsigned work;
+        unsigned src;
+        unsigned dst;
+        unsigned longest_src;
+        unsigned longest_dst;
+    };
+
+    std::vector<Step> journal;
+    double score_before;                // Criterion before `journal`.
+
+    void rescan(void);
+    void place(Start, hw2::Random&);
+    void place_greedy(const std::vector<unsigned>&);
+    unsigned longest_without(unsigned, unsigned) const;
+    void move(unsigned, unsigned, unsigned);
+
+    static std::uint64_t key(unsigned, unsigned);
+
+protected:
+    double evaluate(void) const override;
 
 public:
-    Solution(unsigned, const std::vector<unsigned>&);
-    Solution(const std::filesystem::path&);
+    Solution(InstancePtr, hw2::Random&, Start = Start::Single);
+    Solution(
+        unsigned, const std::vector<unsigned>&, hw2::Random&,
+        Start = Start::Single
+    );
+    Solution(const std::filesystem::path&, hw2::Random&, Start = Start::Single);
+
+    hw2::SolutionPtr clone(void) const override;
+    void commit(void) override;
+    void undo(void) override;
+    void write(std::ostream&) const override;
+    void read(std::istream&) override;
+    double lower_bound(void) const override;
+    bool assign(const hw2::Solution&) override;
+    std::uint64_t move_key(void) const override;
+    std::uint64_t undo_key(void) const override;
 
-    double criterion(void) const override;
     std::vector<std::vector<unsigned>> get_schedule(void) const;
 };
 
-class Scheduling::Mutation: public hw2::Mutation {
+// Picks one of its neighbourhoods at random for every move. With more
+// than one, the choice adapts: each neighbourhood is weighted by a
+// moving average of how its recent moves fared.
+class Scheduling::Mutation final: public hw2::Mutation {
+    static constexpr double decay = 0.05;       // Of the moving average.
+    static constexpr double bonus = 0.05;       // Added to every weight.
+
+    struct Operator {
+        Move move;
+        double quality;
+    };
+
+    std::vector<Operator> ops;
+    unsigned chain;                     // Length of a `Move::Chain`.
+    unsigned current;                   // Operator of the last move.
+
+    unsigned select(hw2::Random&);
+    void shift(Solution&, unsigned, hw2::Random&);
+    void swap(Solution&, hw2::Random&);
+    void balance(Solution&, hw2::Random&);
+    void eject(Solution&, hw2::Random&);
+
+    static unsigned other_proc(const Solution&, unsigned, hw2::Random&);
+    static unsigned work_on(const Solution&, unsigned, unsigned, hw2::Random&);
+
 public:
-    hw2::SolutionPtr mutate(hw2::SolutionPtr) override;
+    Mutation(void);
+    Mutation(std::vector<Move>, unsigned = 3u);
+
+    hw2::MutationPtr clone(void) const override;
+    void propose(hw2::Solution&, hw2::Random&) override;
+    void propose(Solution&, hw2::Random&);
+    void feedback(bool, double) override;
 };
 
 Scheduling::Solution::Solution(
-    unsigned n_proc,
-    const std::vector<unsigned> &work_times
+    InstancePtr inst,
+    hw2::Random &rng,
+    Start start
 )
-    : schedule(n_proc, std::vector<bool>(work_times.size(), false))
-    , times(work_times)
+    : instance(std::move(inst))
+    , times(instance->times())
+    , loads(instance->procs())
+    , score_before(0.)
 {
-    std::mt19937 rng(std::random_device{}());
-    unsigned proc = std::uniform_int_distribution(0u, n_proc - 1u)(rng);
+    place(start, rng);
+    rescan();
+}
 
-    for (unsigned work = 0u; work < times.size(); ++work) {
-        schedule[proc][work] = true;
+Scheduling::Solution::Solution(
+    unsigned n_proc,
+    const std::vector<unsigned> &work_times,
+    hw2::Random &rng,
+    Start start
+)
+    : Solution(
+        std::make_shared<const Instance>(n_proc, work_times), rng, start
+    )
+{}
+
+Scheduling::Solution::Solution(
+    const std::filesystem::path &path,
+    hw2::Random &rng,
+    Start start
+)
+    : Solution(std::make_shared<const Instance>(path), rng, start)
+{}
+
+// Fill `procs` according to `start`, the cached state is left stale.
+void Scheduling::Solution::place(Start start, hw2::Random &rng) {
+    std::vector<unsigned> order(times.size());
+    std::iota(order.begin(), order.end(), 0u);
+
+    switch (start) {
+    case Start::Single:
+        procs.assign(
+            times.size(),
+            std::uniform_int_distribution(0u, instance->procs() - 1u)(rng)
+        );
+        break;
+
+    case Start::RoundRobin:
+        procs.resize(times.size());
+
+        for (unsigned work = 0u; work < times.size(); ++work) {
+            procs[work] = work % loads.size();
+        }
+        break;
+
+    case Start::LPT:
+        std::stable_sort(
+            order.begin(), order.end(),
+            [this](auto i, auto j) { return times[i] > times[j]; }
+        );
+        place_greedy(order);
+        break;
+
+    case Start::RandomGreedy:
+        std::shuffle(order.begin(), order.end(), rng);
+        place_greedy(order);
+        break;
     }
 }
 
-Scheduling::Solution::Solution(const std::filesystem::path &path) {
-    std::ifstream file(path);
+// List scheduling: put the works, in the given order, each on the
+// processor with the least load so far. O(N log M).
+void Scheduling::Solution::place_greedy(const std::vector<unsigned> &order) {
+    using Entry = std::pair<unsigned long, unsigned>;   // (load, proc)
 
-    if (!file.is_open()) {
-        throw std::invalid_argument("can't open file");
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+
+    for (unsigned proc = 0u; proc < loads.size(); ++proc) {
+        heap.push({0ul, proc});
     }
 
-    std::mt19937 rng(std::random_device{}());
-    unsigned n_proc;
-    unsigned time;
+    procs.resize(times.size());
 
-    file >> n_proc;
-    file.get();
-    schedule.resize(n_proc);
-    unsigned proc = std::uniform_int_distribution(0u, n_proc - 1u)(rng);
+    for (auto work: order) {
+        auto [load, proc] = heap.top();
+        heap.pop();
 
-    while (file >> time) {
-        times.push_back(time);
-        schedule[proc].push_back(true);
-        file.get();
+        procs[work] = proc;
+        heap.push({load + times[work], proc});
     }
+}
+
+// Recompute the cached per-processor state from scratch.
+void Scheduling::Solution::rescan(void) {
+    longest.assign(loads.size(), 0u);
+    loads.assign(loads.size(), 0ul);
 
-    for (auto &proc: schedule) {
-        if (proc.empty()) {
-            proc.resize(times.size());
+    for (unsigned work = 0u; work < procs.size(); ++work) {
+        unsigned proc = procs[work];
+
+        if (times[work] > longest[proc]) {
+            longest[proc] = times[work];
         }
+
+        loads[proc] += times[work];
     }
 
-    file.close();
+    invalidate();
 }
 
-double Scheduling::Solution::criterion(void) const {
-    double min = std::numeric_limits<double>::max();
-    double max = 0.;
+// Time of the longest work on `proc` if `work` is taken away from it.
+// Only needs a scan when `work` is the single longest one there, and
+// then it goes over all the works, as they are not indexed by processor.
+unsigned Scheduling::Solution::longest_without(unsigned proc, unsigned work)
+const
+{
+    if (times[work] < longest[proc]) {
+        return longest[proc];
+    }
 
-    for (const auto &proc: schedule) {
-        double cur_min = 0.;
-        double cur_max = 0.;
+    unsigned ans = 0u;
 
-        for (unsigned work = 0u; work < proc.size(); ++work) {
-            if (!proc[work]) {
-                continue;
-            }
+    for (unsigned other = 0u; other < procs.size(); ++other) {
+        if (procs[other] != proc || other == work) {
+            continue;
+        }
 
-            if (times[work] > cur_min) {
-                cur_min = times[work];
-            }
+        if (times[other] == longest[proc]) {
+            return longest[proc];
+        }
 
-            cur_max += times[work];
+        if (times[other] > ans) {
+            ans = times[other];
         }
+    }
+
+    return ans;
+}
+
+// Reassign `work` from `src` to `dst`, updating the cached state.
+// Moves pile up in `journal` until the next commit or undo.
+void Scheduling::Solution::move(unsigned work, unsigned src, unsigned dst) {
+    if (journal.empty()) {
+        score_before = criterion();
+    }
+
+    journal.push_back({work, src, dst, longest[src], longest[dst]});
+    invalidate();
+
+    longest[src] = longest_without(src, work);
+    loads[src] -= times[work];
 
-        if (cur_min < min) {
-            min = cur_min;
+    if (times[work] > longest[dst]) {
+        longest[dst] = times[work];
+    }
+    loads[dst] += times[work];
+
+    procs[work] = dst;
+}
+
+double Scheduling::Solution::evaluate(void) const {
+    double min = std::numeric_limits<double>::max();
+    double max = 0.;
+
+    for (unsigned proc = 0u; proc < loads.size(); ++proc) {
+        if (longest[proc] < min) {
+            min = longest[proc];
         }
 
-        if (cur_max > max) {
-            max = cur_max;
+        if (loads[proc] > max) {
+            max = loads[proc];
         }
     }
 
     return max - min;
 }
 
+hw2::SolutionPtr Scheduling::Solution::clone(void) const {
+    return std::make_shared<Solution>(*this);
+}
+
+// Reuses the buffers of this solution when they are large enough.
+bool Scheduling::Solution::assign(const hw2::Solution &sol) {
+    auto other = dynamic_cast<const Solution*>(&sol);
+
+    if (!other) {
+        return false;
+    }
+
+    *this = *other;
+    return true;
+}
+
+void Scheduling::Solution::commit(void) {
+    journal.clear();
+}
+
+// Revert the proposed moves in O(1) each, latest first, restoring
+// the cached state exactly.
+void Scheduling::Solution::undo(void) {
+    if (journal.empty()) {
+        return;
+    }
+
+    for (auto step = journal.rbegin(); step != journal.rend(); ++step) {
+        loads[step->src] += times[step->work];
+        loads[step->dst] -= times[step->work];
+        longest[step->src] = step->longest_src;
+        longest[step->dst] = step->longest_dst;
+        procs[step->work] = step->src;
+    }
+
+    restore(score_before);
+    journal.clear();
+}
+
+// Hash of "`work` is on `proc`", shifted by one so that it is never
+// zero, which would mean no key.
+std::uint64_t Scheduling::Solution::key(unsigned work, unsigned proc) {
+    return hw2::Random::mix((std::uint64_t(work) << 32 | proc) + 1u);
+}
+
+// The assignments the journal makes, summed so that the order of the
+// steps does not matter: undoing a move makes those it removed.
+std::uint64_t Scheduling::Solution::move_key(void) const {
+    std::uint64_t ans = 0u;
+
+    for (const auto &step: journal) {
+        ans += key(step.work, step.dst);
+    }
+
+    return ans;
+}
+
+std::uint64_t Scheduling::Solution::undo_key(void) const {
+    std::uint64_t ans = 0u;
+
+    for (const auto &step: journal) {
+        ans += key(step.work, step.src);
+    }
+
+    return ans;
+}
+
+// The largest load is at least `max(ceil(T / M), t_max)`, where `T` is
+// the total time. The `M` longest works of the processors are distinct
+// works, so the shortest of them is at most the `M`-th largest time
+// `t_(M)`, zero if there are fewer works than processors.
+// O(N) time and memory, meant to be computed once per run.
+double Scheduling::Solution::lower_bound(void) const {
+    if (times.empty()) {
+        return 0.;
+    }
+
+    std::vector<unsigned> sorted(times.begin(), times.end());
+    unsigned n_proc = loads.size();
+    unsigned long total = std::accumulate(
+        sorted.begin(), sorted.end(), 0ul
+    );
+    unsigned max = *std::max_element(sorted.begin(), sorted.end());
+    unsigned kth = 0u;
+
+    if (sorted.size() >= n_proc) {
+        std::nth_element(
+            sorted.begin(), sorted.begin() + n_proc - 1u, sorted.end(),
+            std::greater<unsigned>()
+        );
+        kth = sorted[n_proc - 1u];
+    }
+
+    unsigned long load = std::max<unsigned long>(
+        (total + n_proc - 1u) / n_proc, max
+    );
+
+    return load > kth ? double(load - kth) : 0.;
+}
+
+// Binary form: the number of works, then the processor of each one,
+// as native-endian 32-bit integers.
+void Scheduling::Solution::write(std::ostream &out) const {
+    std::uint64_t n_works = procs.size();
+
+    out.write(reinterpret_cast<const char*>(&n_works), sizeof(n_works));
+    out.write(
+        reinterpret_cast<const char*>(procs.data()),
+        procs.size() * sizeof(unsigned)
+    );
+}
+
+void Scheduling::Solution::read(std::istream &in) {
+    std::uint64_t n_works;
+    in.read(reinterpret_cast<char*>(&n_works), sizeof(n_works));
+
+    if (!in || n_works != procs.size()) {
+        throw std::invalid_argument("solution of another instance");
+    }
+
+    std::vector<unsigned> saved(procs.size());
+    in.read(
+        reinterpret_cast<char*>(saved.data()),
+        saved.size() * sizeof(unsigned)
+    );
+
+    if (
+        !in
+        || std::any_of(
+            saved.begin(), saved.end(),
+            [this](auto proc) { return proc >= loads.size(); }
+        )
+    ) {
+        throw std::invalid_argument("bad solution data");
+    }
+
+    procs = std::move(saved);
+    journal.clear();
+    rescan();
+}
+
 std::vector<std::vector<unsigned>> Scheduling::Solution::get_schedule(void)
 const
 {
-    std::vector<std::vector<unsigned>> sched;
-
-    for (const auto &proc: schedule) {
-        sched.emplace_back();
+    std::vector<std::vector<unsigned>> sched(loads.size());
 
-        for (unsigned work = 0u; work < proc.size(); ++work) {
-            if (proc[work]) {
-                sched.back().push_back(work);
-            }
-        }
+    for (unsigned work = 0u; work < procs.size(); ++work) {
+        sched[procs[work]].push_back(work);
+    }
 
+    for (auto &proc: sched) {
         std::sort(
-            sched.back().begin(), sched.back().end(),
+            proc.begin(), proc.end(),
             [this](auto i, auto j) { return times[i] > times[j]; }
         );
     }
@@ -137,41 +475,190 @@ const
     return sched;
 }
 
-hw2::SolutionPtr Scheduling::Mutation::mutate(hw2::SolutionPtr sol) {
-    SolutionPtr ans = std::make_shared<Solution>(
-        *std::dynamic_pointer_cast<Solution>(sol)
-    );
+// Only shifts, the original neighbourhood.
+Scheduling::Mutation::Mutation(void): Mutation({Move::Shift}) {}
+
+Scheduling::Mutation::Mutation(std::vector<Move> moves, unsigned length)
+    : chain(length)
+    , current(0u)
+{
+    for (auto move: moves) {
+        ops.push_back({move, 0.5});
+    }
+}
+
+hw2::MutationPtr Scheduling::Mutation::clone(void) const {
+    return std::make_shared<Mutation>(*this);
+}
 
-    if (ans->schedule.size() <= 1u) {
-        return ans;
+void Scheduling::Mutation::propose(hw2::Solution &sol, hw2::Random &rng) {
+    propose(dynamic_cast<Solution&>(sol), rng);
+}
+
+// Statically typed overload, called directly by `hw2::BasicAnnealing`.
+void Scheduling::Mutation::propose(Solution &ans, hw2::Random &rng) {
+    if (ans.loads.size() <= 1u || ans.times.empty()) {
+        return;
     }
 
-    std::mt19937 rng(std::random_device{}());
+    current = select(rng);
+
+    switch (ops[current].move) {
+    case Move::Shift:
+        shift(
+            ans,
+            std::uniform_int_distribution<unsigned>(
+                0u, ans.times.size() - 1u
+            )(rng),
+            rng
+        );
+        break;
+
+    case Move::Swap:
+        swap(ans, rng);
+        break;
+
+    case Move::Balance:
+        balance(ans, rng);
+        break;
+
+    case Move::Chain:
+        eject(ans, rng);
+        break;
+    }
+}
+
+// Rewards a move with 1 if it improved the solution, 0.25 if it was
+// accepted anyway, and 0 if it was rejected.
+void Scheduling::Mutation::feedback(bool accepted, double gain) {
+    double reward = gain > 0. ? 1. : accepted ? 0.25 : 0.;
+    ops[current].quality += decay * (reward - ops[current].quality);
+}
+
+// Roulette wheel over the qualities, each raised by `bonus` so that
+// no neighbourhood is ever abandoned.
+unsigned Scheduling::Mutation::select(hw2::Random &rng) {
+    if (ops.size() == 1u) {
+        return 0u;
+    }
+
+    double total = 0.;
+
+    for (const auto &op: ops) {
+        total += bonus + op.quality;
+    }
+
+    double pick = std::uniform_real_distribution(0., total)(rng);
+
+    for (unsigned i = 0u; i + 1u < ops.size(); ++i) {
+        pick -= bonus + ops[i].quality;
+
+        if (pick < 0.) {
+            return i;
+        }
+    }
+
+    return ops.size() - 1u;
+}
+
+// A processor other than `proc`, uniformly and without rejection.
+unsigned Scheduling::Mutation::other_proc(
+    const Solution &sol,
+    unsigned proc,
+    hw2::Random &rng
+)
+{
+    unsigned ans = std::uniform_int_distribution<unsigned>(
+        0u, sol.loads.size() - 2u
+    )(rng);
+
+    return ans < proc ? ans : ans + 1u;
+}
+
+// A random work on `proc` other than `skip`, or `N` if there is none.
+// Scans from a random position, about `M` works on balanced solutions.
+unsigned Scheduling::Mutation::work_on(
+    const Solution &sol,
+    unsigned proc,
+    unsigned skip,
+    hw2::Random &rng
+)
+{
+    unsigned n_works = sol.procs.size();
+    unsigned start = std::uniform_int_distribution<unsigned>(
+        0u, n_works - 1u
+    )(rng);
+
+    for (unsigned i = 0u; i < n_works; ++i) {
+        unsigned work = start + i < n_works ? start + i : start + i - n_works;
+
+        if (sol.procs[work] == proc && work != skip) {
+            return work;
+        }
+    }
+
+    return n_works;
+}
+
+void Scheduling::Mutation::shift(
+    Solution &ans,
+    unsigned work,
+    hw2::Random &rng
+)
+{
+    unsigned src = ans.procs[work];
+    ans.move(work, src, other_proc(ans, src, rng));
+}
+
+// Two random works trade places, or the first one shifts if they
+// share a processor.
+void Scheduling::Mutation::swap(Solution &ans, hw2::Random &rng) {
     std::uniform_int_distribution<unsigned> dist_work(
-        0u, ans->times.size() - 1u
-    );
-    std::uniform_int_distribution<unsigned> dist_proc(
-        0u, ans->schedule.size() - 1u
+        0u, ans.times.size() - 1u
     );
 
-    unsigned work = dist_work(rng);
-    unsigned src = ans->schedule.size();
-    unsigned dst;
+    unsigned work1 = dist_work(rng);
+    unsigned work2 = dist_work(rng);
+    unsigned proc1 = ans.procs[work1];
+    unsigned proc2 = ans.procs[work2];
 
-    for (unsigned proc = 0u; proc < src; ++proc) {
-        if (ans->schedule[proc][work]) {
-            src = proc;
-        }
+    if (proc1 == proc2) {
+        shift(ans, work1, rng);
+        return;
     }
 
-    do {
-        dst = dist_proc(rng);
-    } while (dst == src);
+    ans.move(work1, proc1, proc2);
+    ans.move(work2, proc2, proc1);
+}
 
-    ans->schedule[src][work] = false;
-    ans->schedule[dst][work] = true;
+void Scheduling::Mutation::balance(Solution &ans, hw2::Random &rng) {
+    auto [min, max] = std::minmax_element(ans.loads.begin(), ans.loads.end());
+    unsigned src = max - ans.loads.begin();
+    unsigned dst = min - ans.loads.begin();
 
-    return ans;
+    if (src == dst) {
+        dst = other_proc(ans, src, rng);
+    }
+
+    unsigned work = work_on(ans, src, ans.procs.size(), rng);
+
+    if (work < ans.procs.size()) {
+        ans.move(work, src, dst);
+    }
+}
+
+void Scheduling::Mutation::eject(Solution &ans, hw2::Random &rng) {
+    unsigned work = std::uniform_int_distribution<unsigned>(
+        0u, ans.times.size() - 1u
+    )(rng);
+
+    for (unsigned i = 0u; i < chain && work < ans.procs.size(); ++i) {
+        unsigned src = ans.procs[work];
+        unsigned dst = other_proc(ans, src, rng);
+
+        ans.move(work, src, dst);
+        work = work_on(ans, dst, work, rng);
+    }
 }
 
 #endif // _HW2_SCHEDULING_H
@@ -0,0 +1,149 @@
+#ifndef _HW2_SLICED_H
+#define _HW2_SLICED_H
+
+#include "annealing.h"
+#include "../hw1/async.h"
+
+#include <algorithm>
+#include <coroutine>
+#include <limits>
+#include <memory>
+#include <random>
+
+namespace hw2 {
+    template<class S, class M, class C>
+    class Sliced;
+} // namespace hw2
+
+// Annealing as a coroutine, for callers that can't give a thread away,
+// e.g. an event loop. `S`, `M` and `C` are as in `BasicAnnealing`, so
+// `Sliced<SolutionRef, MutationRef, CooldownRef>` is the polymorphic one.
+//
+// `run` does a slice of `slice` iterations, then suspends; every
+// `resume` of the returned task does one more. In between, `progress`
+// and `get_best` tell how the run goes. Resuming many tasks round-robin
+// shares a thread fairly between them, as slices are equally long.
+// The task is done once the policy stops it or the lower bound is
+// reached, then `await_resume` returns the best solution.
+//
+// Chains are those of a worker of `BasicAnnealing`, each one from the
+// best solution so far. An object runs one task at a time and must
+// outlive it.
+template<class S, class M, class C>
+class hw2::Sliced {
+public:
+    using Snapshot = std::shared_ptr<const S>;
+
+private:
+    M mutation;
+    C cooldown;
+    Random rng;
+    unsigned slice;
+
+    // State of the current run.
+    Snapshot best;
+    Progress prog;
+    double bound;
+
+public:
+    Sliced(
+        M, C, unsigned = 1024u,
+        Random::result_type = std::random_device{}()
+    );
+    Sliced(const Sliced&) = delete;
+    Sliced &operator=(const Sliced&) = delete;
+
+    hw1::async<Snapshot> run(S);
+    hw1::async<Snapshot> run(S, StoppingPtr);
+
+    Snapshot get_best(void) const { return best; }
+    Progress progress(void) const { return prog; }
+    double gap(void) const { return prog.criterion - bound; }
+};
+
+template<class S, class M, class C>
+hw2::Sliced<S, M, C>::Sliced(
+    M mut,
+    C cd,
+    unsigned iterations,
+    Random::result_type seed
+)
+    : mutation(std::move(mut))
+    , cooldown(std::move(cd))
+    , rng(seed)
+    , slice(std::max(1u, iterations))
+    , best(nullptr)
+    , prog{}
+    , bound(-std::numeric_limits<double>::infinity())
+{}
+
+// Stops after 10 chains in a row without a new best.
+template<class S, class M, class C>
+hw1::async<typename hw2::Sliced<S, M, C>::Snapshot>
+hw2::Sliced<S, M, C>::run(S init) {
+    return run(std::move(init), std::make_shared<BasicStop::Stall>(10u));
+}
+
+// The first slice is done before returning.
+template<class S, class M, class C>
+hw1::async<typename hw2::Sliced<S, M, C>::Snapshot>
+hw2::Sliced<S, M, C>::run(S init, StoppingPtr policy) {
+    M mut = mutation;
+    C cool = cooldown;
+
+    best = std::make_shared<const S>(std::move(init));
+    prog = {0ul, best->criterion(), 0u, {}};
+    bound = -std::numeric_limits<double>::infinity();
+    auto start = Clock::now();
+
+    if constexpr (requires { best->lower_bound(); }) {
+        bound = best->lower_bound();
+    }
+
+    unsigned left = slice;              // Iterations until suspension.
+
+    while (prog.criterion > bound && !policy->done(prog)) {
+        S sol_cur = *best;
+        double crit_start = prog.criterion;
+        Chain chain(sol_cur, mut, cool, rng, bound);
+        bool stopped = false;
+
+        while (!chain.done()) {
+            if (!left) {
+                prog.elapsed = Clock::now() - start;
+                co_await std::suspend_always{};
+                left = slice;
+
+                if (policy->done(prog)) {
+                    stopped = true;
+                    break;
+                }
+            }
+
+            ++prog.evaluations;
+            --left;
+
+            // Visible at the next suspension already.
+            if (chain.step()) {
+                best = std::make_shared<const S>(sol_cur);
+                prog.criterion = chain.best();
+            }
+        }
+
+        if (stopped) {
+            break;
+        }
+
+        if (chain.best() < crit_start) {
+            prog.not_improved = 0u;
+        } else {
+            ++prog.not_improved;
+        }
+
+        prog.elapsed = Clock::now() - start;
+    }
+
+    co_return best;
+}
+
+#endif // _HW2_SLICED_H
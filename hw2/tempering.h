@@ -0,0 +1,211 @@
+#ifndef _HW2_TEMPERING_H
+#define _HW2_TEMPERING_H
+
+#include "annealing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace hw2 {
+    class Tempering;
+} // namespace hw2
+
+// Parallel tempering (replica exchange): one chain per temperature level,
+// spread over a persistent pool of workers. After every sweep the
+// coordinator tries Metropolis swaps between neighbouring levels,
+// alternating between even and odd pairs.
+//
+// A sweep is a `Chain` at the fixed temperature of its level. The run
+// stops as `Budget` says, a round being a sweep of every level, so the
+// workers check the policy in the middle of a sweep too.
+class hw2::Tempering: public hw2::Budget {
+    // The cooldown of a level.
+    struct Level {
+        double temp;
+
+        double get_temp(unsigned) const { return temp; }
+    };
+
+    struct Replica {
+        SolutionPtr cur;
+        double crit;
+        SolutionPtr best;               // Best of the last sweep.
+        double crit_best;
+    };
+
+    std::vector<double> temps;          // From the hottest to the coldest.
+    std::vector<Replica> replicas;      // `replicas[i]` runs at `temps[i]`.
+    SolutionPtr best;
+    MutationPtr mutation;
+    std::vector<MutationPtr> muts;      // One per worker and run.
+    unsigned sweep;
+    Random rng;
+    Workers crew;                       // Last, to stop before the rest.
+
+    void worker(unsigned, Random&);
+    void sweep_payload(Replica&, double, Mutation&, Random&);
+    void exchange(unsigned);
+
+public:
+    Tempering(
+        unsigned, MutationPtr, std::vector<double>, unsigned = 100u,
+        Random::result_type = std::random_device{}()
+    );
+    Tempering(const Tempering&) = delete;
+    Tempering &operator=(const Tempering&) = delete;
+
+    static std::vector<double> ladder(double, double, unsigned);
+
+    SolutionPtr run(SolutionPtr);
+    SolutionPtr run(SolutionPtr, StoppingPtr);
+};
+
+// Worker `id` takes replicas `id`, `id + n_proc`, and so on.
+hw2::Tempering::Tempering(
+    unsigned n_proc,
+    MutationPtr mut,
+    std::vector<double> levels,
+    unsigned steps,
+    Random::result_type seed
+)
+    : temps(std::move(levels))
+    , replicas(temps.size())
+    , best(nullptr)
+    , mutation(mut)
+    , muts(n_proc)
+    , sweep(steps)
+    , rng(seed)
+    , crew(
+        n_proc, [this](unsigned id, Random &gen) { worker(id, gen); }, rng()
+    )
+{}
+
+// `n` temperatures in geometric progression from `hot` down to `cold`.
+std::vector<double> hw2::Tempering::ladder(double hot, double cold, unsigned n)
+{
+    std::vector<double> ans(n, hot);
+
+    for (unsigned i = 1u; i < n; ++i) {
+        ans[i] = hot * std::pow(cold / hot, double(i) / (n - 1u));
+    }
+
+    return ans;
+}
+
+// One sweep of every replica of worker `id`.
+void hw2::Tempering::worker(unsigned id, Random &gen) {
+    for (unsigned i = id; i < replicas.size(); i += crew.size()) {
+        sweep_payload(replicas[i], temps[i], *muts[id], gen);
+    }
+}
+
+// Run `sweep` Metropolis steps at a fixed temperature.
+void hw2::Tempering::sweep_payload(
+    Replica &rep,
+    double temp,
+    Mutation &mut,
+    Random &rng
+)
+{
+    Level level = {temp};
+    Chain chain(*rep.cur, mut, level, rng, bound);
+    SolutionPtr sol_best = nullptr;
+    unsigned pending = 0u;              // Not yet charged.
+
+    for (unsigned it = 0u; it < sweep; ++it) {
+        if (pending == check_period) {
+            bool done = charge(pending);
+            pending = 0u;
+
+            if (done) {
+                break;
+            }
+        }
+
+        bool improved = chain.step();
+        ++pending;
+
+        if (improved) {
+            sol_best = rep.cur->clone();
+
+            if (reached(chain.best())) {
+                break;
+            }
+        }
+    }
+
+    charge(pending);
+    rep.crit = chain.current();
+    rep.best = sol_best;
+    rep.crit_best = chain.best();
+}
+
+// Try to swap the pairs of levels `(i, i + 1)` with `i` of given parity.
+// Swapping the solutions is equivalent to swapping the temperatures.
+void hw2::Tempering::exchange(unsigned parity) {
+    std::uniform_real_distribution dist(0., 1.);
+
+    for (unsigned i = parity; i + 1u < replicas.size(); i += 2u) {
+        Replica &hot = replicas[i];
+        Replica &cold = replicas[i + 1u];
+        double _diff = (cold.crit - hot.crit)
+                     * (1. / temps[i + 1u] - 1. / temps[i]);
+
+        if (_diff >= 0. || dist(rng) < std::exp(_diff)) {
+            std::swap(hot.cur, cold.cur);
+            std::swap(hot.crit, cold.crit);
+        }
+    }
+}
+
+// Stops after 10 sweeps in a row without a new best.
+hw2::SolutionPtr hw2::Tempering::run(SolutionPtr init) {
+    return run(init, std::make_shared<BasicStop::Stall>(10u));
+}
+
+hw2::SolutionPtr hw2::Tempering::run(SolutionPtr init, StoppingPtr policy) {
+    best = init;
+
+    for (auto &rep: replicas) {
+        rep.cur = init->clone();
+        rep.crit = init->criterion();
+    }
+
+    for (auto &mut: muts) {
+        mut = mutation->clone();
+    }
+
+    begin(policy, best->criterion(), best->lower_bound());
+
+    // A replica that didn't improve has no best, and a `crit_best` no
+    // lower than the best of the run.
+    for (unsigned it = 0u; ; ++it) {
+        crew.run();
+
+        const Replica &top = *std::min_element(
+            replicas.begin(), replicas.end(),
+            [](auto &r1, auto &r2) { return r1.crit_best < r2.crit_best; }
+        );
+
+        if (tally(top.crit_best)) {
+            best = top.best;
+        }
+
+        if (exhausted()) {
+            break;
+        }
+
+        exchange(it % 2u);
+    }
+
+    for (auto &rep: replicas) {
+        rep = {};
+    }
+
+    return best;
+}
+
+#endif // _HW2_TEMPERING_H